@@ -0,0 +1,30 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/src/Builtins.cpp" "CMakeFiles/MazeRoboCore.dir/src/Builtins.cpp.o" "gcc" "CMakeFiles/MazeRoboCore.dir/src/Builtins.cpp.o.d"
+  "/root/repo/src/Compiler.cpp" "CMakeFiles/MazeRoboCore.dir/src/Compiler.cpp.o" "gcc" "CMakeFiles/MazeRoboCore.dir/src/Compiler.cpp.o.d"
+  "/root/repo/src/Interpreter.cpp" "CMakeFiles/MazeRoboCore.dir/src/Interpreter.cpp.o" "gcc" "CMakeFiles/MazeRoboCore.dir/src/Interpreter.cpp.o.d"
+  "/root/repo/src/MazeGenerator.cpp" "CMakeFiles/MazeRoboCore.dir/src/MazeGenerator.cpp.o" "gcc" "CMakeFiles/MazeRoboCore.dir/src/MazeGenerator.cpp.o.d"
+  "/root/repo/src/Optimizer.cpp" "CMakeFiles/MazeRoboCore.dir/src/Optimizer.cpp.o" "gcc" "CMakeFiles/MazeRoboCore.dir/src/Optimizer.cpp.o.d"
+  "/root/repo/src/PinBank.cpp" "CMakeFiles/MazeRoboCore.dir/src/PinBank.cpp.o" "gcc" "CMakeFiles/MazeRoboCore.dir/src/PinBank.cpp.o.d"
+  "/root/repo/src/ProgramCache.cpp" "CMakeFiles/MazeRoboCore.dir/src/ProgramCache.cpp.o" "gcc" "CMakeFiles/MazeRoboCore.dir/src/ProgramCache.cpp.o.d"
+  "/root/repo/src/Scheduler.cpp" "CMakeFiles/MazeRoboCore.dir/src/Scheduler.cpp.o" "gcc" "CMakeFiles/MazeRoboCore.dir/src/Scheduler.cpp.o.d"
+  "/root/repo/src/SimClock.cpp" "CMakeFiles/MazeRoboCore.dir/src/SimClock.cpp.o" "gcc" "CMakeFiles/MazeRoboCore.dir/src/SimClock.cpp.o.d"
+  "/root/repo/src/Simulation.cpp" "CMakeFiles/MazeRoboCore.dir/src/Simulation.cpp.o" "gcc" "CMakeFiles/MazeRoboCore.dir/src/Simulation.cpp.o.d"
+  "/root/repo/src/VM.cpp" "CMakeFiles/MazeRoboCore.dir/src/VM.cpp.o" "gcc" "CMakeFiles/MazeRoboCore.dir/src/VM.cpp.o.d"
+  "/root/repo/src/WallGrid.cpp" "CMakeFiles/MazeRoboCore.dir/src/WallGrid.cpp.o" "gcc" "CMakeFiles/MazeRoboCore.dir/src/WallGrid.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
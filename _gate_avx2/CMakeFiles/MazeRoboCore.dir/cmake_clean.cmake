@@ -0,0 +1,33 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/MazeRoboCore.dir/src/Builtins.cpp.o"
+  "CMakeFiles/MazeRoboCore.dir/src/Builtins.cpp.o.d"
+  "CMakeFiles/MazeRoboCore.dir/src/Compiler.cpp.o"
+  "CMakeFiles/MazeRoboCore.dir/src/Compiler.cpp.o.d"
+  "CMakeFiles/MazeRoboCore.dir/src/Interpreter.cpp.o"
+  "CMakeFiles/MazeRoboCore.dir/src/Interpreter.cpp.o.d"
+  "CMakeFiles/MazeRoboCore.dir/src/MazeGenerator.cpp.o"
+  "CMakeFiles/MazeRoboCore.dir/src/MazeGenerator.cpp.o.d"
+  "CMakeFiles/MazeRoboCore.dir/src/Optimizer.cpp.o"
+  "CMakeFiles/MazeRoboCore.dir/src/Optimizer.cpp.o.d"
+  "CMakeFiles/MazeRoboCore.dir/src/PinBank.cpp.o"
+  "CMakeFiles/MazeRoboCore.dir/src/PinBank.cpp.o.d"
+  "CMakeFiles/MazeRoboCore.dir/src/ProgramCache.cpp.o"
+  "CMakeFiles/MazeRoboCore.dir/src/ProgramCache.cpp.o.d"
+  "CMakeFiles/MazeRoboCore.dir/src/Scheduler.cpp.o"
+  "CMakeFiles/MazeRoboCore.dir/src/Scheduler.cpp.o.d"
+  "CMakeFiles/MazeRoboCore.dir/src/SimClock.cpp.o"
+  "CMakeFiles/MazeRoboCore.dir/src/SimClock.cpp.o.d"
+  "CMakeFiles/MazeRoboCore.dir/src/Simulation.cpp.o"
+  "CMakeFiles/MazeRoboCore.dir/src/Simulation.cpp.o.d"
+  "CMakeFiles/MazeRoboCore.dir/src/VM.cpp.o"
+  "CMakeFiles/MazeRoboCore.dir/src/VM.cpp.o.d"
+  "CMakeFiles/MazeRoboCore.dir/src/WallGrid.cpp.o"
+  "CMakeFiles/MazeRoboCore.dir/src/WallGrid.cpp.o.d"
+  "libMazeRoboCore.a"
+  "libMazeRoboCore.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/MazeRoboCore.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
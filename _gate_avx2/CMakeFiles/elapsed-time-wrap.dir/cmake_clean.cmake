@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/elapsed-time-wrap.dir/tests/ElapsedTimeWrap.cpp.o"
+  "CMakeFiles/elapsed-time-wrap.dir/tests/ElapsedTimeWrap.cpp.o.d"
+  "elapsed-time-wrap"
+  "elapsed-time-wrap.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/elapsed-time-wrap.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/hot-reload.dir/tests/HotReload.cpp.o"
+  "CMakeFiles/hot-reload.dir/tests/HotReload.cpp.o.d"
+  "hot-reload"
+  "hot-reload.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/hot-reload.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/lockstep-determinism.dir/tests/LockstepDeterminism.cpp.o"
+  "CMakeFiles/lockstep-determinism.dir/tests/LockstepDeterminism.cpp.o.d"
+  "lockstep-determinism"
+  "lockstep-determinism.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/lockstep-determinism.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/mazerobo-bench.dir/tools/MazeRoboBench.cpp.o"
+  "CMakeFiles/mazerobo-bench.dir/tools/MazeRoboBench.cpp.o.d"
+  "mazerobo-bench"
+  "mazerobo-bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/mazerobo-bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
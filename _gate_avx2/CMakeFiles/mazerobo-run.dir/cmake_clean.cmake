@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/mazerobo-run.dir/tools/MazeRoboRun.cpp.o"
+  "CMakeFiles/mazerobo-run.dir/tools/MazeRoboRun.cpp.o.d"
+  "mazerobo-run"
+  "mazerobo-run.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/mazerobo-run.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
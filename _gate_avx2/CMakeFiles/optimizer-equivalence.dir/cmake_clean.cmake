@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/optimizer-equivalence.dir/tests/OptimizerEquivalence.cpp.o"
+  "CMakeFiles/optimizer-equivalence.dir/tests/OptimizerEquivalence.cpp.o.d"
+  "optimizer-equivalence"
+  "optimizer-equivalence.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/optimizer-equivalence.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/pinbank-stress.dir/tests/PinBankStress.cpp.o"
+  "CMakeFiles/pinbank-stress.dir/tests/PinBankStress.cpp.o.d"
+  "pinbank-stress"
+  "pinbank-stress.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/pinbank-stress.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
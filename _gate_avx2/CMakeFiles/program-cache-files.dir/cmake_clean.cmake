@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/program-cache-files.dir/tests/ProgramCacheFiles.cpp.o"
+  "CMakeFiles/program-cache-files.dir/tests/ProgramCacheFiles.cpp.o.d"
+  "program-cache-files"
+  "program-cache-files.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/program-cache-files.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
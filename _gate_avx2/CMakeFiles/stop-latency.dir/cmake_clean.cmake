@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/stop-latency.dir/tests/StopLatency.cpp.o"
+  "CMakeFiles/stop-latency.dir/tests/StopLatency.cpp.o.d"
+  "stop-latency"
+  "stop-latency.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/stop-latency.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
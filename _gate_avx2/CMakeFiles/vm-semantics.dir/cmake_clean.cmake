@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/vm-semantics.dir/tests/VmSemantics.cpp.o"
+  "CMakeFiles/vm-semantics.dir/tests/VmSemantics.cpp.o.d"
+  "vm-semantics"
+  "vm-semantics.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/vm-semantics.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
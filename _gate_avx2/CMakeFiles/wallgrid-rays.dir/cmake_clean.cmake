@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/wallgrid-rays.dir/tests/WallGridRays.cpp.o"
+  "CMakeFiles/wallgrid-rays.dir/tests/WallGridRays.cpp.o.d"
+  "wallgrid-rays"
+  "wallgrid-rays.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/wallgrid-rays.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
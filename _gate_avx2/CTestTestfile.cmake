@@ -0,0 +1,24 @@
+# CMake generated Testfile for 
+# Source directory: /root/repo
+# Build directory: /root/repo/_gate_avx2
+# 
+# This file includes the relevant testing commands required for 
+# testing this directory and lists subdirectories to be tested as well.
+add_test(pinbank-stress "/root/repo/_gate_avx2/pinbank-stress" "2")
+set_tests_properties(pinbank-stress PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;42;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(elapsed-time-wrap "/root/repo/_gate_avx2/elapsed-time-wrap")
+set_tests_properties(elapsed-time-wrap PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;45;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(program-cache-files "/root/repo/_gate_avx2/program-cache-files")
+set_tests_properties(program-cache-files PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;48;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(wallgrid-rays "/root/repo/_gate_avx2/wallgrid-rays")
+set_tests_properties(wallgrid-rays PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;51;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(optimizer-equivalence "/root/repo/_gate_avx2/optimizer-equivalence")
+set_tests_properties(optimizer-equivalence PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;54;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(vm-semantics "/root/repo/_gate_avx2/vm-semantics")
+set_tests_properties(vm-semantics PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;57;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(stop-latency "/root/repo/_gate_avx2/stop-latency")
+set_tests_properties(stop-latency PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;60;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(hot-reload "/root/repo/_gate_avx2/hot-reload")
+set_tests_properties(hot-reload PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;63;add_test;/root/repo/CMakeLists.txt;0;")
+add_test(lockstep-determinism "/root/repo/_gate_avx2/lockstep-determinism" "/root/repo/examples/flood_fill.cpp")
+set_tests_properties(lockstep-determinism PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;66;add_test;/root/repo/CMakeLists.txt;0;")
@@ -0,0 +1,79 @@
+// Integer-heavy benchmark: breadth-first flood fill over a 64x64 grid
+//
+// setup() scatters walls over the grid with a small linear congruential
+// generator, floods it from the top-left corner and adds up the distances,
+// REPEAT times with different walls. Nothing here touches the robot, so
+// the time it takes is the interpreter's own. Run it with
+//
+//   mazerobo-bench run --script examples/flood_fill.cpp
+//
+// Every value stays below 2^24 and nothing is divided, so the script does
+// the same work whether ints are computed exactly or as floats. The
+// checksum ends up on pin 13.
+
+const int W = 64;
+const int H = 64;
+const int CELLS = 4096;
+const int REPEAT = 20;
+
+int walls[4096];
+int dist[4096];
+int queueX[4096];
+int queueY[4096];
+int checksum = 0;
+
+void scatterWalls(int seed) {
+    int x = seed;
+    for (int i = 0; i < CELLS; i++) {
+        x = (x * 75 + 74) % 65537;
+        walls[i] = !(x % 4); // A wall on about one cell in four
+    }
+    walls[0] = 0;
+}
+
+// Queues cell (x, y) at distance d if it is open and not reached yet
+int visit(int x, int y, int d, int tail) {
+    int n = y * W + x;
+    if (!walls[n] && dist[n] < 0) {
+        dist[n] = d;
+        queueX[tail] = x;
+        queueY[tail] = y;
+        tail++;
+    }
+    return tail;
+}
+
+int flood() {
+    for (int i = 0; i < CELLS; i++) dist[i] = -1;
+    int head = 0;
+    int tail = 0;
+    dist[0] = 0;
+    queueX[0] = 0;
+    queueY[0] = 0;
+    tail++;
+    int total = 0;
+    while (head < tail) {
+        int x = queueX[head];
+        int y = queueY[head];
+        head++;
+        int d = dist[y * W + x];
+        total = total + d;
+        if (x > 0) tail = visit(x - 1, y, d + 1, tail);
+        if (x < W - 1) tail = visit(x + 1, y, d + 1, tail);
+        if (y > 0) tail = visit(x, y - 1, d + 1, tail);
+        if (y < H - 1) tail = visit(x, y + 1, d + 1, tail);
+    }
+    return total;
+}
+
+void setup() {
+    for (int r = 0; r < REPEAT; r++) {
+        scatterWalls(r + 1);
+        checksum = (checksum * 31 + flood()) % 65521;
+    }
+    digitalWrite(13, checksum);
+}
+
+void loop() {
+    delay(1000);
+}
@@ -14,7 +14,7 @@ const int TURN_TIME = 400; // Time to turn 90 deg
 int distF; int distL; int distR;
 pile pathStack; // Tracks the path: 1=F, 2=R, 3=L
 
-// Sensor Function
+// Sensor Function: pulseIn() waits for a reading taken after the last move
 int readDistance(int trig, int echo) {
     return pulseIn(echo, 1, 30000) * 0.034 / 2;
 }
@@ -30,24 +30,20 @@ void moveOneCell() {
     forward();
     delay(MOVE_TIME);
     stop();
-    delay(200); // Stabilize
 }
 
 void moveBackOneCell() {
     backward();
     delay(MOVE_TIME);
     stop();
-    delay(200);
 }
 
 void turnLeft90() {
     left(); // Built-in 90 deg turn
-    delay(200);
 }
 
 void turnRight90() {
     right(); // Built-in 90 deg turn
-    delay(200);
 }
 
 // Recursive DFS Solver
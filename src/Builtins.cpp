@@ -0,0 +1,196 @@
+#include "Interpreter.h"
+#include <algorithm>
+
+// --- Built-ins ---
+// Calls to these are bound to a table index by Resolve(), so the VM
+// dispatches them without comparing names.
+
+void Interpreter::RegisterBuiltin(const std::string& name, BuiltinFn fn, bool firstArgByRef, StaticType result) {
+    auto it = builtinIndices.find(name);
+    if (it != builtinIndices.end()) {
+        builtins[it->second] = {name, fn, firstArgByRef, result};
+        return;
+    }
+    builtinIndices[name] = (int)builtins.size();
+    builtins.push_back({name, fn, firstArgByRef, result});
+}
+
+// Motor driver inputs IN1..IN4 live on pins 8-11; each command is published
+// as one PinBank update so the render loop never sees half of it
+static void SetMotors(Interpreter& in, int in1, int in2, int in3, int in4) {
+    const int values[4] = { in1, in2, in3, in4 };
+    in.SetPinValues(8, values, 4);
+}
+
+// Arduino's default pulseIn() timeout
+static const int64_t kPulseTimeoutMicros = 1000000;
+// How often a waiting pulseIn() looks for a fresh reading; the simulation
+// publishes one per physics step
+static const int64_t kEchoPollMicros = 1000;
+
+// Sets `result` to the echo duration once the reading is fresh, or to 0 when
+// the pin has no sensor or the timeout passed. Otherwise sleeps and tries
+// again, storing over the placeholder pulseIn() returned.
+void Interpreter::PollEcho(Value& result) {
+    float distance;
+    uint32_t pinSequence;
+    bool wired = sensorSource ? sensorSource(pulseEcho, distance, pinSequence)
+                              : pins.ReadSensor(pulseEcho, distance, pinSequence);
+    if (!wired) {
+        result = Value(0);
+        return;
+    }
+    if ((int32_t)(pinSequence - motorCommand) >= 0) {
+        result = Value(distance * 2.0f / 0.034f);
+        return;
+    }
+    int64_t remaining = pulseDeadline - clock->NowMicros();
+    if (remaining <= 0) {
+        result = Value(0);
+        return;
+    }
+    RequestSleep(std::min(remaining, kEchoPollMicros), [](Interpreter& in) {
+        if (!in.valueStack.empty()) in.PollEcho(in.valueStack.back());
+    });
+}
+
+// Like PollEcho(), for lidar(): `result` becomes the beam count once a fresh
+// scan has been copied into the array, or 0 without a lidar or on timeout
+void Interpreter::PollScan(Value& result) {
+    if (!scanSource || !scanArray || scanArray->type != VAL_ARRAY) {
+        result = Value(0);
+        return;
+    }
+    scanBuffer.resize(scanArray->object->arrayElements.size());
+    uint32_t pinSequence;
+    int beams = scanSource(scanBuffer.data(), (int)scanBuffer.size(), pinSequence);
+    if (beams <= 0) {
+        result = Value(0);
+        return;
+    }
+    if ((int32_t)(pinSequence - motorCommand) >= 0) {
+        auto& elements = scanArray->Unshare()->arrayElements;
+        int count = std::min(beams, (int)elements.size());
+        for (int i = 0; i < count; i++) {
+            // Keep the element type: an int array gets whole centimetres
+            if (elements[i].type == VAL_FLOAT) elements[i] = Value(scanBuffer[i]);
+            else elements[i] = Value((int)scanBuffer[i]);
+        }
+        result = Value(beams);
+        return;
+    }
+    int64_t remaining = pulseDeadline - clock->NowMicros();
+    if (remaining <= 0) {
+        result = Value(0);
+        return;
+    }
+    RequestSleep(std::min(remaining, kEchoPollMicros), [](Interpreter& in) {
+        if (!in.valueStack.empty()) in.PollScan(in.valueStack.back());
+    });
+}
+
+void Interpreter::RegisterBuiltins() {
+    RegisterBuiltin("digitalWrite", [](Interpreter& in, Value* args, int argc) {
+        if (argc == 2) in.SetPinValue(args[0].AsInt(), args[1].AsInt());
+        return Value();
+    });
+    RegisterBuiltin("delay", [](Interpreter& in, Value* args, int argc) {
+        if (argc >= 1) in.RequestSleep(args[0].AsInt() * 1000LL);
+        return Value();
+    });
+    RegisterBuiltin("delayMicroseconds", [](Interpreter& in, Value* args, int argc) {
+        if (argc >= 1) in.RequestSleep(args[0].AsInt());
+        return Value();
+    });
+    // Arduino returns these as unsigned long, wrapping at 2^32. Scripts only
+    // have 32-bit ints, so the same bits read negative past 2^31 (micros()
+    // after 35.8 minutes); `micros() - start` still gives the elapsed time.
+    RegisterBuiltin("millis", [](Interpreter& in, Value*, int) {
+        in.slicePolled = true;
+        return Value((int)(uint32_t)(in.clock->NowMicros() / 1000));
+    }, false, TYPE_INT);
+    RegisterBuiltin("micros", [](Interpreter& in, Value*, int) {
+        in.slicePolled = true;
+        return Value((int)(uint32_t)in.clock->NowMicros());
+    }, false, TYPE_INT);
+    RegisterBuiltin("pulseIn", [](Interpreter& in, Value* args, int argc) {
+        Value result(0);
+        if (argc >= 1) {
+            in.slicePolled = true;
+            in.pulseEcho = args[0].AsInt();
+            int64_t timeout = argc >= 3 ? args[2].AsInt() : kPulseTimeoutMicros;
+            in.pulseDeadline = in.clock->NowMicros() + timeout;
+            in.PollEcho(result);
+        }
+        return result;
+    });
+    RegisterBuiltin("digitalRead", [](Interpreter& in, Value* args, int argc) {
+        if (argc < 1) return Value(0);
+        in.slicePolled = true;
+        int pin = args[0].AsInt();
+        int level;
+        if (in.digitalSource && in.digitalSource(pin, level)) return Value(level);
+        return Value(in.GetPinValue(pin));
+    }, false, TYPE_INT);
+    // lidar(scan): fills the array with the lidar's distances (cm), like pulseIn()
+    // waiting for a scan taken after the last motor command
+    RegisterBuiltin("lidar", [](Interpreter& in, Value* args, int argc) {
+        Value result(0);
+        if (argc >= 1 && args[0].type == VAL_REF) {
+            in.slicePolled = true;
+            in.scanArray = args[0].refVal;
+            in.pulseDeadline = in.clock->NowMicros() + kPulseTimeoutMicros;
+            in.PollScan(result);
+        }
+        return result;
+    }, true, TYPE_INT);
+
+    // Piles: the first argument arrives as a VAL_REF to the pile variable
+    RegisterBuiltin("push", [](Interpreter&, Value* args, int argc) {
+        if (argc == 2 && args[0].type == VAL_REF && args[0].refVal && args[0].refVal->type == VAL_PILE) {
+            args[0].refVal->Unshare()->pileElements.push_back(args[1].AsInt());
+        }
+        return Value();
+    }, true);
+    RegisterBuiltin("pop", [](Interpreter&, Value* args, int argc) {
+        if (argc == 1 && args[0].type == VAL_REF && args[0].refVal && args[0].refVal->type == VAL_PILE) {
+            auto& pile = args[0].refVal->Unshare()->pileElements;
+            if (!pile.empty()) {
+                int v = pile.back();
+                pile.pop_back();
+                return Value(v);
+            }
+        }
+        return Value(0);
+    }, true, TYPE_INT);
+
+    // Movement Built-ins
+    RegisterBuiltin("forward", [](Interpreter& in, Value*, int) {
+        SetMotors(in, 1, 0, 1, 0);
+        return Value();
+    });
+    RegisterBuiltin("backward", [](Interpreter& in, Value*, int) {
+        SetMotors(in, 0, 1, 0, 1);
+        return Value();
+    });
+    RegisterBuiltin("left", [](Interpreter& in, Value*, int) {
+        // Rotate 90 degrees left
+        // Simulate by turning in place for a specific time
+        SetMotors(in, 0, 1, 1, 0); // Left Bwd, Right Fwd
+        in.RequestSleep(400 * 1000, [](Interpreter& in) { SetMotors(in, 0, 0, 0, 0); }); // Calibrated delay
+        return Value();
+    });
+    RegisterBuiltin("right", [](Interpreter& in, Value*, int) {
+        // Rotate 90 degrees right
+        SetMotors(in, 1, 0, 0, 1); // Left Fwd, Right Bwd
+        in.RequestSleep(400 * 1000, [](Interpreter& in) { SetMotors(in, 0, 0, 0, 0); }); // Calibrated delay
+        return Value();
+    });
+    RegisterBuiltin("stop", [](Interpreter& in, Value*, int) {
+        SetMotors(in, 0, 0, 0, 0);
+        return Value();
+    });
+
+    RegisterBuiltin("pinMode", [](Interpreter&, Value*, int) { return Value(); });
+    RegisterBuiltin("Serial.begin", [](Interpreter&, Value*, int) { return Value(); });
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+
+// --- Bytecode ---
+// The parser's AST is lowered once into a flat instruction array that the
+// VM walks with an instruction pointer. Operands live on a value stack;
+// lvalues are pushed as VAL_REF values pointing at their storage.
+
+enum OpCode : uint8_t {
+    // Constants
+    OP_PUSH_NUM,      // a = float bits
+    OP_PUSH_INT,      // a = value
+    OP_PUSH_BOOL,     // a = 0 / 1
+    OP_PUSH_VOID,
+    OP_PUSH_DEFAULT,  // a = type name
+    OP_NEW_ARRAY,     // a = element type name, pops size
+    OP_POP,
+
+    // Variables (a = frame slot or global index, resolved before compilation)
+    OP_LOAD_LOCAL,
+    OP_LOAD_GLOBAL,
+    OP_ADDR_LOCAL,
+    OP_ADDR_GLOBAL,
+    OP_PUSH_NULL_REF, // address of an undeclared name
+    OP_DECL_LOCAL,    // pops initial value, b = 1 for reference declarations
+    OP_DECL_GLOBAL,   // pops initial value, b = 1 for reference declarations
+
+    // Lvalues (b = AccessMode)
+    OP_ADDR_MEMBER,   // a = member name, pops ref
+    OP_ADDR_INDEX,    // pops index, pops ref
+    OP_LOAD_REF,      // pops ref, pushes copy of target
+    OP_STORE,         // pops value, pops ref, pushes value
+    OP_PRE_INC, OP_PRE_DEC, OP_POST_INC, OP_POST_DEC, // pop ref
+
+    // Arithmetic / logic. The plain forms work in float (MOD in int); the _I
+    // forms are chosen when both operands are statically int and wrap at 32 bits.
+    OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_MOD,
+    OP_LT, OP_GT,
+    OP_NEG, OP_NOT,
+    OP_ADD_I, OP_SUB_I, OP_MUL_I, OP_DIV_I,
+    OP_LT_I, OP_GT_I,
+    OP_NEG_I,
+    OP_TO_BOOL, OP_TO_INT, OP_TO_FLOAT,
+
+    // Control flow (a = target)
+    OP_JUMP,
+    OP_JUMP_IF_FALSE, // pops condition
+    OP_JUMP_IF_TRUE,  // pops condition
+    OP_LOOP_HEAD,     // top of every loop iteration: stop check + scheduling
+
+    // Calls
+    OP_CALL,          // a = function index, b = argument count
+    OP_CALL_BUILTIN,  // a = builtin index, b = argument count
+    OP_RETURN         // pops return value
+};
+
+// What an element or member address will be used for. Aggregates are
+// shared copy-on-write, so only writers unshare the container, and a
+// reference that outlives the instruction (ref declarations, ref parameters,
+// ref returns, `&x`) also pins it so later copies cannot share its storage.
+enum AccessMode : uint8_t {
+    ACCESS_READ,      // Loaded straight away
+    ACCESS_WRITE,     // Stored to or incremented straight away
+    ACCESS_BIND       // Kept as a reference
+};
+
+struct Instr {
+    OpCode op;
+    uint8_t b;
+    int32_t a;
+};
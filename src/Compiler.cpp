@@ -0,0 +1,601 @@
+#include "Interpreter.h"
+#include <cstring>
+
+static bool IsIntegral(StaticType t) { return t == TYPE_INT || t == TYPE_BOOL; }
+
+// Conversions pass aggregates through (see OP_TO_INT), so the base of an
+// element or member access looks through them, e.g. an inlined `(int)arr`
+static ExprId AggregateBase(const Ast& ast, ExprId id) {
+    while (ast.exprs[id].kind == EXPR_UNARY) {
+        TokenType op = ast.exprs[id].unary.op;
+        if (op != TOKEN_INT && op != TOKEN_FLOAT && op != TOKEN_BOOL) break;
+        id = ast.exprs[id].unary.right;
+    }
+    return id;
+}
+
+// --- Resolver ---
+// Binds every variable reference to a global index or a frame slot so the VM
+// never looks names up at run time. Locals are function-scoped: a name
+// declared twice in one function shares a slot.
+//
+// Alongside, every expression gets a static type from the declarations it
+// reads so the compiler can pick integer or float instructions. A slot
+// declared with two different types is left untyped.
+
+void Interpreter::Resolve() {
+    int globalCount = 0;
+    const BlockStmt& globalBlock = ast.stmts[globalInit.body].block;
+    for (uint32_t i = 0; i < globalBlock.count; i++) {
+        VarDeclStmt& decl = ast.stmts[ast.children[globalBlock.first + i]].decl;
+        const std::string& name = ast.Name(decl.name);
+        auto it = globalIndices.find(name);
+        if (it == globalIndices.end()) it = globalIndices.insert({name, globalCount++}).first;
+        decl.slot = it->second;
+    }
+    globals.assign(globalCount, Value());
+    globalTypes.assign(globalCount, SlotType());
+    for (uint32_t i = 0; i < globalBlock.count; i++) {
+        const VarDeclStmt& decl = ast.stmts[ast.children[globalBlock.first + i]].decl;
+        DeclareType(globalTypes, decl.slot, decl.type, decl.isArray);
+    }
+
+    functionTable.clear();
+    for (auto& entry : functions) {
+        entry.second.index = (int)functionTable.size();
+        functionTable.push_back(&entry.second);
+    }
+
+    ResolveStmt(globalInit.body, {});
+    for (auto& entry : functions) ResolveFunction(entry.second);
+}
+
+void Interpreter::ResolveFunction(FunctionDef& func) {
+    std::map<NameId, int> locals;
+    localTypes.clear();
+    for (auto& param : func.parameters) {
+        NameId name = ast.Intern(param.second);
+        if (!locals.count(name)) {
+            int slot = (int)locals.size();
+            locals[name] = slot;
+        }
+        DeclareType(localTypes, locals[name], ast.Intern(param.first), false);
+    }
+    DeclareLocals(func.body, locals);
+    func.localCount = (int)locals.size();
+    ResolveStmt(func.body, locals);
+}
+
+void Interpreter::DeclareType(std::vector<SlotType>& types, int slot, NameId type, bool isArray) {
+    if (slot >= (int)types.size()) types.resize(slot + 1);
+    SlotType& t = types[slot];
+    if (t.conflict) return;
+    if (t.known && (t.type != type || t.isArray != isArray)) {
+        t.known = false;
+        t.conflict = true;
+        return;
+    }
+    t.type = type;
+    t.isArray = isArray;
+    t.known = true;
+}
+
+StaticType Interpreter::TypeOfName(std::string_view type) const {
+    if (!type.empty() && type.back() == '&') type.remove_suffix(1);
+    if (type == "int" || type == "long" || enums.count(type)) return TYPE_INT;
+    if (type == "float") return TYPE_FLOAT;
+    if (type == "bool") return TYPE_BOOL;
+    return TYPE_UNKNOWN;
+}
+
+// The declared type of a variable, element or member, if the resolver can
+// tell. Call after the expression's children are resolved.
+bool Interpreter::DeclaredType(ExprId id, SlotType& out) {
+    const Expr& expr = ast.exprs[id];
+    switch (expr.kind) {
+        case EXPR_VARIABLE: {
+            const VariableExpr& var = expr.variable;
+            const std::vector<SlotType>& types = var.isGlobal ? globalTypes : localTypes;
+            if (var.slot < 0 || var.slot >= (int)types.size() || !types[var.slot].known) return false;
+            out = types[var.slot];
+            return true;
+        }
+        case EXPR_INDEX:
+            if (!DeclaredType(expr.index.array, out) || !out.isArray) return false;
+            out.isArray = false;
+            return true;
+        case EXPR_MEMBER: {
+            if (!DeclaredType(expr.member.object, out) || out.isArray) return false;
+            std::string_view structName = ast.Name(out.type);
+            if (!structName.empty() && structName.back() == '&') structName.remove_suffix(1);
+            auto s = structs.find(structName);
+            if (s == structs.end()) return false;
+            auto m = s->second.members.find(ast.Name(expr.member.member));
+            if (m == s->second.members.end()) return false;
+            out.type = ast.Intern(m->second);
+            return true;
+        }
+        case EXPR_CALL:
+            if (expr.call.function < 0) return false;
+            out = SlotType();
+            out.type = ast.Intern(functionTable[expr.call.function]->returnType);
+            out.known = true;
+            return true;
+        default:
+            return false;
+    }
+}
+
+void Interpreter::DeclareLocals(StmtId id, std::map<NameId, int>& locals) {
+    if (id == kNoNode) return;
+    Stmt& stmt = ast.stmts[id];
+    switch (stmt.kind) {
+        case STMT_BLOCK:
+            for (uint32_t i = 0; i < stmt.block.count; i++) DeclareLocals(ast.children[stmt.block.first + i], locals);
+            break;
+        case STMT_IF:
+            DeclareLocals(stmt.ifStmt.thenBranch, locals);
+            DeclareLocals(stmt.ifStmt.elseBranch, locals);
+            break;
+        case STMT_WHILE:
+        case STMT_DO_WHILE:
+            DeclareLocals(stmt.loop.body, locals);
+            break;
+        case STMT_FOR:
+            DeclareLocals(stmt.forStmt.init, locals);
+            DeclareLocals(stmt.forStmt.body, locals);
+            break;
+        case STMT_VAR_DECL: {
+            auto it = locals.find(stmt.decl.name);
+            if (it == locals.end()) {
+                int slot = (int)locals.size();
+                it = locals.insert({stmt.decl.name, slot}).first;
+            }
+            stmt.decl.slot = it->second;
+            DeclareType(localTypes, stmt.decl.slot, stmt.decl.type, stmt.decl.isArray);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void Interpreter::ResolveStmt(StmtId id, const std::map<NameId, int>& locals) {
+    if (id == kNoNode) return;
+    const Stmt& stmt = ast.stmts[id];
+    switch (stmt.kind) {
+        case STMT_BLOCK:
+            for (uint32_t i = 0; i < stmt.block.count; i++) ResolveStmt(ast.children[stmt.block.first + i], locals);
+            break;
+        case STMT_IF:
+            ResolveExpr(stmt.ifStmt.condition, locals);
+            ResolveStmt(stmt.ifStmt.thenBranch, locals);
+            ResolveStmt(stmt.ifStmt.elseBranch, locals);
+            break;
+        case STMT_WHILE:
+        case STMT_DO_WHILE:
+            ResolveStmt(stmt.loop.body, locals);
+            ResolveExpr(stmt.loop.condition, locals);
+            break;
+        case STMT_FOR:
+            ResolveStmt(stmt.forStmt.init, locals);
+            ResolveExpr(stmt.forStmt.condition, locals);
+            ResolveExpr(stmt.forStmt.increment, locals);
+            ResolveStmt(stmt.forStmt.body, locals);
+            break;
+        case STMT_RETURN:
+            ResolveExpr(stmt.ret.value, locals);
+            break;
+        case STMT_EXPR:
+            ResolveExpr(stmt.expr.expression, locals);
+            break;
+        case STMT_VAR_DECL:
+            ResolveExpr(stmt.decl.initializer, locals);
+            ResolveExpr(stmt.decl.arraySize, locals);
+            break;
+    }
+}
+
+void Interpreter::ResolveExpr(ExprId id, const std::map<NameId, int>& locals) {
+    if (id == kNoNode) return;
+    Expr& expr = ast.exprs[id];
+    switch (expr.kind) {
+        case EXPR_VARIABLE: {
+            VariableExpr& var = expr.variable;
+            auto local = locals.find(var.name);
+            if (local != locals.end()) {
+                var.slot = local->second;
+                var.isGlobal = false;
+            } else {
+                auto global = globalIndices.find(ast.Name(var.name));
+                var.slot = global != globalIndices.end() ? global->second : -1;
+                var.isGlobal = true;
+            }
+            break;
+        }
+        case EXPR_BINARY: {
+            const BinaryExpr& b = expr.binary;
+            ResolveExpr(b.left, locals);
+            ResolveExpr(b.right, locals);
+            switch (b.op) {
+                case TOKEN_PLUS: case TOKEN_MINUS: case TOKEN_STAR: case TOKEN_SLASH:
+                    // bool operands promote to int; anything else takes the float path
+                    expr.type = IsIntegral(ast.exprs[b.left].type) && IsIntegral(ast.exprs[b.right].type)
+                        ? TYPE_INT : TYPE_FLOAT;
+                    break;
+                case TOKEN_MOD:
+                    expr.type = TYPE_INT;
+                    break;
+                case TOKEN_LT: case TOKEN_GT: case TOKEN_AND: case TOKEN_OR:
+                    expr.type = TYPE_BOOL;
+                    break;
+                default:
+                    break;
+            }
+            break;
+        }
+        case EXPR_UNARY: {
+            const UnaryExpr& u = expr.unary;
+            ResolveExpr(u.right, locals);
+            StaticType operand = ast.exprs[u.right].type;
+            switch (u.op) {
+                case TOKEN_NOT: case TOKEN_BOOL: expr.type = TYPE_BOOL; break;
+                case TOKEN_INT: expr.type = TYPE_INT; break;
+                case TOKEN_FLOAT: expr.type = TYPE_FLOAT; break;
+                case TOKEN_MINUS: expr.type = IsIntegral(operand) ? TYPE_INT : TYPE_FLOAT; break;
+                case TOKEN_INC: case TOKEN_DEC: expr.type = operand; break;
+                default: break;
+            }
+            break;
+        }
+        case EXPR_POSTFIX:
+            ResolveExpr(expr.postfix.left, locals);
+            expr.type = ast.exprs[expr.postfix.left].type;
+            break;
+        case EXPR_CALL: {
+            CallExpr& call = expr.call;
+            const std::string& callee = ast.Name(call.callee);
+            auto func = functions.find(callee);
+            if (func != functions.end()) {
+                call.function = func->second.index;
+            } else {
+                auto builtin = builtinIndices.find(callee);
+                call.builtin = builtin != builtinIndices.end() ? builtin->second : -1;
+            }
+            for (uint32_t i = 0; i < call.argCount; i++) ResolveExpr(ast.children[call.firstArg + i], locals);
+            if (call.function < 0 && call.builtin >= 0) expr.type = builtins[call.builtin].result;
+            break;
+        }
+        case EXPR_MEMBER:
+            ResolveExpr(expr.member.object, locals);
+            break;
+        case EXPR_INDEX:
+            ResolveExpr(expr.index.array, locals);
+            ResolveExpr(expr.index.index, locals);
+            break;
+        case EXPR_ASSIGN: {
+            ResolveExpr(expr.assign.target, locals);
+            ResolveExpr(expr.assign.value, locals);
+            // The store converts to a typed target; an untyped one keeps the value as is
+            StaticType target = ast.exprs[expr.assign.target].type;
+            expr.type = target != TYPE_UNKNOWN ? target : ast.exprs[expr.assign.value].type;
+            break;
+        }
+        case EXPR_LITERAL: {
+            const LiteralExpr& l = expr.literal;
+            expr.type = l.isBool ? TYPE_BOOL : l.isInt ? TYPE_INT : TYPE_FLOAT;
+            break;
+        }
+    }
+    SlotType declared;
+    if ((expr.kind == EXPR_VARIABLE || expr.kind == EXPR_INDEX || expr.kind == EXPR_MEMBER || expr.kind == EXPR_CALL) &&
+        DeclaredType(id, declared) && !declared.isArray) {
+        expr.type = TypeOfName(ast.Name(declared.type));
+    }
+}
+
+// --- Compiler ---
+// Lowers the parsed AST into Interpreter::code. Runs once per Load().
+
+void Interpreter::Compile() {
+    code.clear();
+    codeLines.clear();
+    names.clear();
+    nameIndices.clear();
+
+    CompileFunction(globalInit, true);
+    for (auto& entry : functions) {
+        CompileFunction(entry.second, false);
+    }
+}
+
+void Interpreter::CompileFunction(FunctionDef& func, bool isGlobalInit) {
+    compilingFunction = &func;
+    compilingGlobals = isGlobalInit;
+
+    func.entry = (int)code.size();
+    CompileStmt(func.body);
+    // Falling off the end returns void
+    Emit(OP_PUSH_VOID);
+    Emit(OP_RETURN);
+
+    compilingFunction = nullptr;
+    compilingGlobals = false;
+}
+
+int Interpreter::Emit(OpCode op, int a, int b) {
+    code.push_back({op, (uint8_t)b, a});
+    codeLines.push_back(compilingLine);
+    return (int)code.size() - 1;
+}
+
+void Interpreter::PatchJump(int at) {
+    code[at].a = (int)code.size();
+}
+
+int Interpreter::NameIndex(const std::string& name) {
+    auto it = nameIndices.find(name);
+    if (it != nameIndices.end()) return it->second;
+    int index = (int)names.size();
+    names.push_back(name);
+    nameIndices[name] = index;
+    return index;
+}
+
+void Interpreter::CompileStmt(StmtId id) {
+    if (id == kNoNode) return;
+
+    const Stmt& stmt = ast.stmts[id];
+    // Code after a nested statement (loop jumps, OP_RETURN) belongs to this one
+    int outerLine = compilingLine;
+    if (stmt.line) compilingLine = stmt.line;
+    switch (stmt.kind) {
+        case STMT_BLOCK: {
+            const BlockStmt& block = stmt.block;
+            for (uint32_t i = 0; i < block.count; i++) CompileStmt(ast.children[block.first + i]);
+            break;
+        }
+        case STMT_IF: {
+            const IfStmt& ifStmt = stmt.ifStmt;
+            CompileExpr(ifStmt.condition);
+            int toElse = Emit(OP_JUMP_IF_FALSE);
+            CompileStmt(ifStmt.thenBranch);
+            if (ifStmt.elseBranch) {
+                int toEnd = Emit(OP_JUMP);
+                PatchJump(toElse);
+                CompileStmt(ifStmt.elseBranch);
+                PatchJump(toEnd);
+            } else {
+                PatchJump(toElse);
+            }
+            break;
+        }
+        case STMT_WHILE: {
+            const WhileStmt& whileStmt = stmt.loop;
+            int top = Emit(OP_LOOP_HEAD);
+            CompileExpr(whileStmt.condition);
+            int toEnd = Emit(OP_JUMP_IF_FALSE);
+            CompileStmt(whileStmt.body);
+            Emit(OP_JUMP, top);
+            PatchJump(toEnd);
+            break;
+        }
+        case STMT_DO_WHILE: {
+            const WhileStmt& doStmt = stmt.loop;
+            int top = Emit(OP_LOOP_HEAD);
+            CompileStmt(doStmt.body);
+            CompileExpr(doStmt.condition);
+            Emit(OP_JUMP_IF_TRUE, top);
+            break;
+        }
+        case STMT_FOR: {
+            const ForStmt& forStmt = stmt.forStmt;
+            CompileStmt(forStmt.init);
+            int top = Emit(OP_LOOP_HEAD);
+            int toEnd = -1;
+            if (forStmt.condition) {
+                CompileExpr(forStmt.condition);
+                toEnd = Emit(OP_JUMP_IF_FALSE);
+            }
+            CompileStmt(forStmt.body);
+            if (forStmt.increment) {
+                CompileExpr(forStmt.increment);
+                Emit(OP_POP);
+            }
+            Emit(OP_JUMP, top);
+            if (toEnd != -1) PatchJump(toEnd);
+            break;
+        }
+        case STMT_RETURN: {
+            const ReturnStmt& ret = stmt.ret;
+            if (!ret.value) {
+                Emit(OP_PUSH_VOID);
+            } else if (compilingFunction && !compilingFunction->returnType.empty() &&
+                       compilingFunction->returnType.back() == '&') {
+                CompileAddress(ret.value, ACCESS_BIND);
+            } else {
+                CompileConverted(ret.value, compilingFunction ? TypeOfName(compilingFunction->returnType) : TYPE_UNKNOWN);
+            }
+            Emit(OP_RETURN);
+            break;
+        }
+        case STMT_EXPR: {
+            CompileExpr(stmt.expr.expression);
+            Emit(OP_POP);
+            break;
+        }
+        case STMT_VAR_DECL: {
+            const VarDeclStmt& decl = stmt.decl;
+            const std::string& type = ast.Name(decl.type);
+            bool isRef = !type.empty() && type.back() == '&';
+            if (decl.isArray) {
+                CompileExpr(decl.arraySize);
+                Emit(OP_NEW_ARRAY, NameIndex(type));
+            } else if (decl.initializer) {
+                if (isRef) CompileAddress(decl.initializer, ACCESS_BIND);
+                else CompileConverted(decl.initializer, TypeOfName(type));
+            } else {
+                Emit(OP_PUSH_DEFAULT, NameIndex(type));
+            }
+            Emit(compilingGlobals ? OP_DECL_GLOBAL : OP_DECL_LOCAL, decl.slot, isRef ? 1 : 0);
+            break;
+        }
+    }
+    compilingLine = outerLine;
+}
+
+void Interpreter::CompileAddress(ExprId id, AccessMode mode) {
+    const Expr& expr = ast.exprs[id];
+    switch (expr.kind) {
+        case EXPR_VARIABLE: {
+            const VariableExpr& var = expr.variable;
+            if (var.slot < 0) Emit(OP_PUSH_NULL_REF);
+            else Emit(var.isGlobal ? OP_ADDR_GLOBAL : OP_ADDR_LOCAL, var.slot);
+            return;
+        }
+        case EXPR_MEMBER: {
+            const MemberExpr& member = expr.member;
+            CompileAddress(AggregateBase(ast, member.object), mode);
+            Emit(OP_ADDR_MEMBER, NameIndex(ast.Name(member.member)), mode);
+            return;
+        }
+        case EXPR_INDEX: {
+            const IndexExpr& index = expr.index;
+            CompileAddress(AggregateBase(ast, index.array), mode);
+            CompileExpr(index.index);
+            Emit(OP_ADDR_INDEX, 0, mode);
+            return;
+        }
+        default:
+            // Not an lvalue: fall back to the plain value
+            CompileExpr(id);
+            return;
+    }
+}
+
+void Interpreter::CompileConverted(ExprId id, StaticType to) {
+    CompileExpr(id);
+    if (to == TYPE_UNKNOWN || to == ast.exprs[id].type) return;
+    Emit(to == TYPE_INT ? OP_TO_INT : to == TYPE_FLOAT ? OP_TO_FLOAT : OP_TO_BOOL);
+}
+
+void Interpreter::CompileExpr(ExprId id) {
+    const Expr& expr = ast.exprs[id];
+    switch (expr.kind) {
+        case EXPR_LITERAL: {
+            const LiteralExpr& l = expr.literal;
+            if (l.isBool) {
+                Emit(OP_PUSH_BOOL, l.boolVal ? 1 : 0);
+            } else if (l.isInt) {
+                Emit(OP_PUSH_INT, l.intVal);
+            } else {
+                int bits;
+                std::memcpy(&bits, &l.numberVal, sizeof(bits));
+                Emit(OP_PUSH_NUM, bits);
+            }
+            return;
+        }
+        case EXPR_VARIABLE: {
+            const VariableExpr& var = expr.variable;
+            if (var.slot < 0) Emit(OP_PUSH_VOID);
+            else Emit(var.isGlobal ? OP_LOAD_GLOBAL : OP_LOAD_LOCAL, var.slot);
+            return;
+        }
+        case EXPR_MEMBER:
+        case EXPR_INDEX:
+            CompileAddress(id, ACCESS_READ);
+            Emit(OP_LOAD_REF);
+            return;
+        case EXPR_ASSIGN: {
+            const AssignExpr& a = expr.assign;
+            CompileAddress(a.target, ACCESS_WRITE);
+            CompileConverted(a.value, ast.exprs[a.target].type);
+            Emit(OP_STORE);
+            return;
+        }
+        case EXPR_BINARY: {
+            const BinaryExpr& b = expr.binary;
+            if (b.op == TOKEN_AND || b.op == TOKEN_OR) {
+                // Short-circuit: the right side only runs when it decides the result
+                CompileExpr(b.left);
+                int toShort = Emit(b.op == TOKEN_AND ? OP_JUMP_IF_FALSE : OP_JUMP_IF_TRUE);
+                CompileExpr(b.right);
+                Emit(OP_TO_BOOL);
+                int toEnd = Emit(OP_JUMP);
+                PatchJump(toShort);
+                Emit(OP_PUSH_BOOL, b.op == TOKEN_OR ? 1 : 0);
+                PatchJump(toEnd);
+                return;
+            }
+            CompileExpr(b.left);
+            CompileExpr(b.right);
+            bool integral = IsIntegral(ast.exprs[b.left].type) && IsIntegral(ast.exprs[b.right].type);
+            switch (b.op) {
+                case TOKEN_PLUS: Emit(integral ? OP_ADD_I : OP_ADD); break;
+                case TOKEN_MINUS: Emit(integral ? OP_SUB_I : OP_SUB); break;
+                case TOKEN_STAR: Emit(integral ? OP_MUL_I : OP_MUL); break;
+                case TOKEN_SLASH: Emit(integral ? OP_DIV_I : OP_DIV); break;
+                case TOKEN_MOD: Emit(OP_MOD); break;
+                case TOKEN_LT: Emit(integral ? OP_LT_I : OP_LT); break;
+                case TOKEN_GT: Emit(integral ? OP_GT_I : OP_GT); break;
+                default: Emit(OP_POP); Emit(OP_POP); Emit(OP_PUSH_VOID); break;
+            }
+            return;
+        }
+        case EXPR_UNARY: {
+            const UnaryExpr& u = expr.unary;
+            switch (u.op) {
+                case TOKEN_NOT: CompileExpr(u.right); Emit(OP_NOT); break;
+                case TOKEN_MINUS:
+                    CompileExpr(u.right);
+                    Emit(IsIntegral(ast.exprs[u.right].type) ? OP_NEG_I : OP_NEG);
+                    break;
+                case TOKEN_INT: CompileConverted(u.right, TYPE_INT); break;
+                case TOKEN_FLOAT: CompileConverted(u.right, TYPE_FLOAT); break;
+                case TOKEN_BOOL: CompileConverted(u.right, TYPE_BOOL); break;
+                case TOKEN_INC: CompileAddress(u.right, ACCESS_WRITE); Emit(OP_PRE_INC); break;
+                case TOKEN_DEC: CompileAddress(u.right, ACCESS_WRITE); Emit(OP_PRE_DEC); break;
+                case TOKEN_AMPERSAND: CompileAddress(u.right, ACCESS_BIND); break;
+                default: Emit(OP_PUSH_VOID); break;
+            }
+            return;
+        }
+        case EXPR_POSTFIX: {
+            const PostfixExpr& p = expr.postfix;
+            CompileAddress(p.left, ACCESS_WRITE);
+            Emit(p.op == TOKEN_INC ? OP_POST_INC : OP_POST_DEC);
+            return;
+        }
+        case EXPR_CALL: {
+            const CallExpr& c = expr.call;
+            const FunctionDef* function = c.function >= 0 ? functionTable[c.function] : nullptr;
+            for (uint32_t i = 0; i < c.argCount; i++) {
+                // Reference parameters (and the first argument of push/pop/lidar) receive the
+                // argument's storage rather than a copy
+                bool byRef = false;
+                if (function) {
+                    auto& params = function->parameters;
+                    byRef = i < params.size() && !params[i].first.empty() && params[i].first.back() == '&';
+                } else if (c.builtin >= 0) {
+                    byRef = i == 0 && builtins[c.builtin].firstArgByRef;
+                }
+                ExprId arg = ast.children[c.firstArg + i];
+                // A builtin is done with its reference before the script moves on (lidar()
+                // may sleep first); a script function keeps it
+                if (byRef) CompileAddress(arg, function ? ACCESS_BIND : ACCESS_WRITE);
+                else if (function && i < function->parameters.size()) CompileConverted(arg, TypeOfName(function->parameters[i].first));
+                else CompileExpr(arg);
+            }
+            if (function) {
+                Emit(OP_CALL, function->index, (int)c.argCount);
+            } else if (c.builtin >= 0) {
+                Emit(OP_CALL_BUILTIN, c.builtin, (int)c.argCount);
+            } else {
+                // Unknown callee: arguments are still evaluated, the result is void
+                for (uint32_t i = 0; i < c.argCount; i++) Emit(OP_POP);
+                Emit(OP_PUSH_VOID);
+            }
+            return;
+        }
+    }
+}
@@ -120,6 +120,10 @@ void IDE::Draw(MazeGenerator& maze, Simulation& simulation) {
     // Speed Control
     ImGui::Text("Simulation Speed (Step Delay):");
     ImGui::SliderFloat("##speed", &simulation.stepDelay, 0.1f, 2.0f, "%.1f s");
+    ImGui::SameLine();
+    ImGui::Checkbox("Simulated time (fast-forward)", &simulation.useSimulatedTime);
+    ImGui::SameLine();
+    ImGui::Checkbox("Lockstep (reproducible)", &simulation.useLockstep);
     
     if (ImGui::Button("<- Back to Maze Generator")) {
         goBack = true;
@@ -129,6 +133,8 @@ void IDE::Draw(MazeGenerator& maze, Simulation& simulation) {
     if (ImGui::Button("Format Code")) {
         AutoFormat();
     }
+    ImGui::SameLine();
+    ImGui::Checkbox("Print optimized program", &simulation.dumpProgram);
     
     ImGui::End();
     
@@ -199,7 +205,7 @@ void IDE::DrawRobotPreview(int x, int y, int w, int h) {
     DrawText("Commands:", cmdX, cmdY, 20, DARKGRAY);
     DrawText("- forward(), backward()", cmdX, cmdY + 25, 10, BLACK);
     DrawText("- left(), right() (90 deg)", cmdX, cmdY + 40, 10, BLACK);
-    DrawText("- stop()", cmdX, cmdY + 55, 10, BLACK);
+    DrawText("- stop(), delay(ms), millis()", cmdX, cmdY + 55, 10, BLACK);
     DrawText("Variables:", cmdX, cmdY + 75, 20, DARKGRAY);
     DrawText("- fdist, ldist, rdist", cmdX, cmdY + 100, 10, BLACK);
 }
@@ -226,7 +232,7 @@ void IDE::DrawMazePreview(MazeGenerator& maze, int x, int y, int w, int h) {
     float startX = x + 20;
     float startY = y + 30;
     
-    for (const auto& cell : maze.grid) {
+    for (const auto& cell : maze.Cells()) {
         float cx = startX + cell.x * finalCellSize;
         float cy = startY + cell.y * finalCellSize;
         
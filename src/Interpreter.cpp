@@ -1,13 +1,18 @@
 #include "Interpreter.h"
+#include "ProgramCache.h"
+#include "Scheduler.h"
 #include <cctype>
 #include <cstdlib>
 #include <iostream>
 #include <cmath>
 #include <chrono>
+#include <algorithm>
+#include <array>
 
 Interpreter::Interpreter() {
     currentToken = 0;
     isRunning = false;
+    RegisterBuiltins();
 }
 
 Interpreter::~Interpreter() {
@@ -16,75 +21,362 @@ Interpreter::~Interpreter() {
 
 void Interpreter::Load(const std::string& code) {
     Stop(); // Ensure stopped before loading
-    
+    reloadPending = false;
+    pins.Clear();
+    BuildProgram(code);
+}
+
+void Interpreter::BuildProgram(const std::string& code) {
     source = code;
-    Tokenize();
-    currentToken = 0;
+    // Dumping shows the parser's output, so it bypasses the cache
+    ProgramCache* cache = programDump ? nullptr : programCache;
+    uint64_t variant = cache ? FrontEndVariant() : 0;
+    std::shared_ptr<const ParsedProgram> cached = cache ? cache->Find(source, variant) : nullptr;
+    tokens.clear();
+    if (!cached) {
+        Tokenize();
+        currentToken = 0;
+    }
     
     std::lock_guard<std::mutex> lock(memoryMutex);
     globals.clear();
-    functions.clear();
-    structs.clear();
-    enums.clear();
-    pinValues.clear();
-    sensorValues.clear();
+    globalIndices.clear();
     callStack.clear();
-    
-    ParseProgram();
+    valueStack.clear();
+    if (cached) {
+        // Resolve() writes slots and types into the AST, so work on a copy
+        ast = cached->ast;
+        functions = cached->functions;
+        structs = cached->structs;
+        enums = cached->enums;
+        globalInit = cached->globalInit;
+    } else {
+        functions.clear();
+        structs.clear();
+        enums.clear();
+        globalInit = FunctionDef();
+        globalInit.name = "<globals>";
+        globalInit.returnType = "void";
+        ast.Clear();
+        
+        ParseProgram();
+        if (programDump) DumpProgram(*programDump, "parsed");
+        if (optimize) {
+            Optimize();
+            if (programDump) DumpProgram(*programDump, "optimized");
+        }
+        if (cache) {
+            auto parsed = std::make_shared<ParsedProgram>();
+            parsed->ast = ast;
+            parsed->functions = functions;
+            parsed->structs = structs;
+            parsed->enums = enums;
+            parsed->globalInit = globalInit;
+            cache->Insert(source, variant, std::move(parsed));
+        }
+    }
+    Resolve();
+    Compile();
+}
+
+uint64_t Interpreter::FrontEndVariant() const {
+    // The optimizer asks which builtins take their first argument by reference
+    std::string settings = optimize ? "O" : "-";
+    for (const BuiltinDef& builtin : builtins) {
+        settings += builtin.name;
+        settings += builtin.firstArgByRef ? '&' : ',';
+    }
+    return ProgramCache::Hash(settings);
+}
+
+void Interpreter::Reload(const std::string& code) {
+    if (!isRunning) {
+        Load(code);
+        return;
+    }
+    std::lock_guard<std::mutex> lock(reloadMutex);
+    reloadSource = code;
+    reloadPending = true;
+}
+
+// Whether a kept global still fits its new declaration: same kind, array
+// lengths and struct members all the way down
+static bool SameShape(const Value& a, const Value& b) {
+    if (a.type != b.type) return false;
+    if (a.type == VAL_ARRAY) {
+        const auto& left = a.object->arrayElements;
+        const auto& right = b.object->arrayElements;
+        if (left.size() != right.size()) return false;
+        for (size_t i = 0; i < left.size(); i++) {
+            if (!SameShape(left[i], right[i])) return false;
+        }
+    } else if (a.type == VAL_STRUCT) {
+        const auto& left = a.object->members;
+        const auto& right = b.object->members;
+        if (a.object->structName != b.object->structName || left.size() != right.size()) return false;
+        for (auto l = left.begin(), r = right.begin(); l != left.end(); ++l, ++r) {
+            if (l->first != r->first || !SameShape(l->second, r->second)) return false;
+        }
+    }
+    return true;
+}
+
+void Interpreter::ApplyReload() {
+    std::string code;
+    {
+        std::lock_guard<std::mutex> lock(reloadMutex);
+        code.swap(reloadSource);
+        reloadPending = false;
+    }
+    // Constants are never kept: the optimizer has already substituted the
+    // new values into the code
+    keptGlobals.clear();
+    {
+        std::lock_guard<std::mutex> lock(memoryMutex);
+        const BlockStmt& globalBlock = ast.stmts[globalInit.body].block;
+        for (uint32_t i = 0; i < globalBlock.count; i++) {
+            const VarDeclStmt& decl = ast.stmts[ast.children[globalBlock.first + i]].decl;
+            if (decl.isConst || globals[decl.slot].type == VAL_REF) continue;
+            keptGlobals.push_back({ast.Name(decl.name), ast.Name(decl.type), decl.isArray, globals[decl.slot]});
+        }
+    }
+    BuildProgram(code);
+    valueStack.clear();
+    auto setup = functions.find("setup");
+    auto loop = functions.find("loop");
+    setupFunction = setup != functions.end() ? &setup->second : nullptr;
+    loopFunction = loop != functions.end() ? &loop->second : nullptr;
+    phase = PHASE_RELOAD_GLOBALS;
+}
+
+void Interpreter::RestoreGlobals() {
+    std::lock_guard<std::mutex> lock(memoryMutex);
+    std::map<std::string, const KeptGlobal*> kept;
+    for (const KeptGlobal& global : keptGlobals) kept[global.name] = &global;
+    const BlockStmt& globalBlock = ast.stmts[globalInit.body].block;
+    for (uint32_t i = 0; i < globalBlock.count; i++) {
+        const VarDeclStmt& decl = ast.stmts[ast.children[globalBlock.first + i]].decl;
+        auto it = kept.find(ast.Name(decl.name));
+        if (decl.isConst || it == kept.end()) continue;
+        const KeptGlobal& old = *it->second;
+        if (old.type == ast.Name(decl.type) && old.isArray == decl.isArray &&
+            SameShape(old.value, globals[decl.slot])) {
+            globals[decl.slot] = old.value;
+        }
+    }
+    keptGlobals.clear();
 }
 
 void Interpreter::Start() {
     if (isRunning) return;
+    // The previous run may have stopped itself on a runtime error
+    Stop();
+    {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        runtimeError.clear();
+    }
+    clock->Reset();
+    clock->ScriptStarted();
+    sliceRemaining = kSliceIterations;
+    sliceEffects = 0;
+    slicePolled = false;
+    // A stopped run may have been suspended mid-call
+    callStack.clear();
+    valueStack.clear();
+    auto setup = functions.find("setup");
+    auto loop = functions.find("loop");
+    setupFunction = setup != functions.end() ? &setup->second : nullptr;
+    loopFunction = loop != functions.end() ? &loop->second : nullptr;
+    phase = PHASE_GLOBALS;
+    resumeIp = -1;
+    wakeAction = nullptr;
+    motorCommand = pins.Sequence();
     isRunning = true;
-    executionThread = std::thread(&Interpreter::RunLoop, this);
+    if (lockstep) {
+        lockstepActive = true;
+        lockstepWake = 0;
+        return;
+    }
+    activeScheduler = scheduler;
+    if (activeScheduler) activeScheduler->Submit(this);
+    else executionThread = std::thread(&Interpreter::RunLoop, this);
 }
 
 void Interpreter::Stop() {
     isRunning = false;
+    clock->Interrupt();
+    if (activeScheduler) {
+        activeScheduler->Remove(this);
+        activeScheduler = nullptr;
+    }
     if (executionThread.joinable()) {
         executionThread.join();
     }
+    if (lockstepActive) {
+        lockstepActive = false;
+        FinishRun();
+    }
+}
+
+int64_t Interpreter::RunLockstep(std::chrono::steady_clock::time_point deadline) {
+    while (isRunning) {
+        int64_t now = clock->NowMicros();
+        if (lockstepWake > now) return lockstepWake;
+        StepResult result = Step();
+        if (result == STEP_SLEEP) lockstepWake = now + sleepMicros;
+        else if (result == STEP_YIELD && std::chrono::steady_clock::now() >= deadline) return now;
+    }
+    if (lockstepActive) {
+        lockstepActive = false;
+        FinishRun();
+    }
+    return INT64_MAX;
 }
 
 void Interpreter::RunLoop() {
-    {
-        CallFunction("setup", {});
+    for (;;) {
+        StepResult result = Step();
+        if (result == STEP_DONE) break;
+        if (result == STEP_SLEEP) clock->SleepFor(sleepMicros, isRunning);
+    }
+    FinishRun();
+}
+
+Interpreter::StepResult Interpreter::Step() {
+    yieldRequested = false;
+    sleepMicros = 0;
+    if (wakeAction) {
+        auto action = wakeAction;
+        wakeAction = nullptr;
+        action(*this);
+    }
+    while (isRunning && !yieldRequested) {
+        if (resumeIp >= 0) {
+            int ip = resumeIp;
+            resumeIp = -1;
+            Run(ip, 0);
+        } else if (phase == PHASE_GLOBALS) {
+            phase = PHASE_SETUP;
+            Invoke(globalInit);
+        } else if (phase == PHASE_SETUP) {
+            phase = PHASE_LOOP;
+            if (setupFunction) Invoke(*setupFunction);
+        } else if (phase == PHASE_RELOAD_GLOBALS) {
+            phase = PHASE_RELOAD_RESTORE;
+            Invoke(globalInit);
+        } else if (phase == PHASE_RELOAD_RESTORE) {
+            RestoreGlobals();
+            phase = PHASE_LOOP;
+        } else if (reloadPending) {
+            ApplyReload();
+        } else {
+            if (loopFunction) Invoke(*loopFunction);
+            if (!yieldRequested && --sliceRemaining <= 0) EndSlice();
+        }
     }
-    
-    while (isRunning) {
-        CallFunction("loop", {});
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    if (!isRunning) return STEP_DONE;
+    return sleepMicros > 0 ? STEP_SLEEP : STEP_YIELD;
+}
+
+void Interpreter::FinishRun() {
+    // A builtin stopped mid-sleep still completes, e.g. a turn stops its motors
+    if (wakeAction) {
+        auto action = wakeAction;
+        wakeAction = nullptr;
+        action(*this);
     }
+    clock->ScriptFinished();
+}
+
+void Interpreter::RequestSleep(int64_t micros, void (*then)(Interpreter&)) {
+    if (micros <= 0) {
+        if (then) then(*this);
+        return;
+    }
+    yieldRequested = true;
+    sleepMicros = micros;
+    wakeAction = then;
+}
+
+std::string Interpreter::GetRuntimeError() {
+    std::lock_guard<std::mutex> lock(errorMutex);
+    return runtimeError;
 }
 
 int Interpreter::GetPinValue(int pin) {
-    std::lock_guard<std::mutex> lock(memoryMutex);
-    if (pinValues.find(pin) != pinValues.end()) return pinValues[pin];
-    return 0;
+    return pins.ReadPin(pin);
+}
+
+uint32_t Interpreter::GetPinValues(int firstPin, int count, int* out) {
+    return pins.ReadPins(firstPin, count, out);
 }
 
 void Interpreter::SetPinValue(int pin, int value) {
-    std::lock_guard<std::mutex> lock(memoryMutex);
-    pinValues[pin] = value;
+    SetPinValues(pin, &value, 1);
 }
 
-void Interpreter::SetSensorValue(int trigPin, int echoPin, float distance) {
-    std::lock_guard<std::mutex> lock(memoryMutex);
-    sensorValues[echoPin] = distance;
+void Interpreter::SetPinValues(int firstPin, const int* values, int count) {
+    pins.WritePins(firstPin, values, count);
+    // Motor driver inputs: readings from before this are stale to pulseIn()
+    if (firstPin <= 11 && firstPin + count > 8) motorCommand = pins.Sequence();
+}
+
+void Interpreter::SetSensorValue(int /*trigPin*/, int echoPin, float distance, uint32_t pinSequence) {
+    pins.WriteSensor(echoPin, distance, pinSequence);
+}
+
+void Interpreter::SetSensorValue(int /*trigPin*/, int echoPin, float distance) {
+    pins.WriteSensor(echoPin, distance, pins.Sequence());
 }
 
 void Interpreter::SetVariable(const std::string& name, float value) {
     std::lock_guard<std::mutex> lock(memoryMutex);
-    if (globals.count(name)) {
-        globals[name] = Value(value);
+    auto it = globalIndices.find(name);
+    if (it != globalIndices.end()) {
+        globals[it->second] = Value(value);
     }
 }
 
 // --- Tokenizer ---
+// Tokens are views into `source`; nothing is copied until the parser interns
+// a name into the AST.
+
+struct Keyword {
+    const char* text;
+    TokenType type;
+};
+
+static const Keyword kKeywords[] = {
+    {"if", TOKEN_IF}, {"else", TOKEN_ELSE}, {"int", TOKEN_INT}, {"float", TOKEN_FLOAT},
+    {"long", TOKEN_LONG}, {"bool", TOKEN_BOOL}, {"void", TOKEN_VOID}, {"const", TOKEN_CONST},
+    {"enum", TOKEN_ENUM}, {"struct", TOKEN_STRUCT}, {"return", TOKEN_RETURN}, {"while", TOKEN_WHILE},
+    {"do", TOKEN_DO}, {"for", TOKEN_FOR}, {"pile", TOKEN_PILE}, {"true", TOKEN_TRUE},
+    {"false", TOKEN_FALSE}
+};
+
+// (length + first char + last char) mod 32 is collision-free over kKeywords,
+// so one table probe and one compare classify any identifier
+static unsigned KeywordHash(std::string_view text) {
+    return (unsigned)(text.size() + (unsigned char)text.front() + (unsigned char)text.back()) & 31;
+}
+
+static TokenType LookupKeyword(std::string_view text) {
+    static const std::array<const Keyword*, 32> table = [] {
+        std::array<const Keyword*, 32> t = {};
+        for (const Keyword& k : kKeywords) t[KeywordHash(k.text)] = &k;
+        return t;
+    }();
+    const Keyword* k = table[KeywordHash(text)];
+    return (k && text == k->text) ? k->type : TOKEN_ID;
+}
+
 void Interpreter::Tokenize() {
     tokens.clear();
     int i = 0;
     int line = 1;
+    auto push = [&](TokenType type, int start, int length) {
+        tokens.push_back({type, (uint32_t)start, (uint32_t)length, line, 0.0f});
+    };
     while (i < source.length()) {
         char c = source[i];
         if (c == '\n') { line++; i++; continue; }
@@ -105,85 +397,69 @@ void Interpreter::Tokenize() {
         }
 
         if (c == '&' && i + 1 < source.length() && source[i+1] == '&') {
-            tokens.push_back({TOKEN_AND, "&&", 0, line}); i += 2; continue;
+            push(TOKEN_AND, i, 2); i += 2; continue;
         }
         if (c == '|' && i + 1 < source.length() && source[i+1] == '|') {
-            tokens.push_back({TOKEN_OR, "||", 0, line}); i += 2; continue;
+            push(TOKEN_OR, i, 2); i += 2; continue;
         }
         if (c == '+' && i + 1 < source.length() && source[i+1] == '+') {
-            tokens.push_back({TOKEN_INC, "++", 0, line}); i += 2; continue;
+            push(TOKEN_INC, i, 2); i += 2; continue;
         }
         if (c == '-' && i + 1 < source.length() && source[i+1] == '-') {
-            tokens.push_back({TOKEN_DEC, "--", 0, line}); i += 2; continue;
+            push(TOKEN_DEC, i, 2); i += 2; continue;
         }
         
-        Token t; t.line = line;
+        int start = i;
         if (isalpha(c) || c == '_') {
-            std::string text;
-            while (i < source.length() && (isalnum(source[i]) || source[i] == '_')) text += source[i++];
-            t.text = text;
-            if (text == "if") t.type = TOKEN_IF;
-            else if (text == "else") t.type = TOKEN_ELSE;
-            else if (text == "int") t.type = TOKEN_INT;
-            else if (text == "float") t.type = TOKEN_FLOAT;
-            else if (text == "long") t.type = TOKEN_LONG;
-            else if (text == "bool") t.type = TOKEN_BOOL;
-            else if (text == "void") t.type = TOKEN_VOID;
-            else if (text == "const") t.type = TOKEN_CONST;
-            else if (text == "enum") t.type = TOKEN_ENUM;
-            else if (text == "struct") t.type = TOKEN_STRUCT;
-            else if (text == "return") t.type = TOKEN_RETURN;
-            else if (text == "while") t.type = TOKEN_WHILE;
-            else if (text == "do") t.type = TOKEN_DO;
-            else if (text == "for") t.type = TOKEN_FOR;
-            else if (text == "pile") t.type = TOKEN_PILE;
-            else if (text == "true") t.type = TOKEN_TRUE;
-            else if (text == "false") t.type = TOKEN_FALSE;
-            else t.type = TOKEN_ID;
+            while (i < source.length() && (isalnum(source[i]) || source[i] == '_')) i++;
+            push(LookupKeyword(std::string_view(source).substr(start, i - start)), start, i - start);
         } else if (isdigit(c)) {
-            std::string text;
-            while (i < source.length() && (isdigit(source[i]) || source[i] == '.')) text += source[i++];
-            t.text = text;
-            t.type = TOKEN_NUMBER;
-            t.numberValue = std::stof(text);
+            while (i < source.length() && (isdigit(source[i]) || source[i] == '.')) i++;
+            push(TOKEN_NUMBER, start, i - start);
+            // strtof on a bounded copy: it must not read past the token (e.g. "1e5")
+            char digits[64];
+            size_t n = std::min<size_t>(i - start, sizeof(digits) - 1);
+            source.copy(digits, n, start);
+            digits[n] = '\0';
+            tokens.back().numberValue = std::strtof(digits, nullptr);
         } else {
-            t.text = std::string(1, c);
+            TokenType type;
             switch (c) {
-                case '{': t.type = TOKEN_LBRACE; break;
-                case '}': t.type = TOKEN_RBRACE; break;
-                case '(': t.type = TOKEN_LPAREN; break;
-                case ')': t.type = TOKEN_RPAREN; break;
-                case '[': t.type = TOKEN_LBRACKET; break;
-                case ']': t.type = TOKEN_RBRACKET; break;
-                case ';': t.type = TOKEN_SEMICOLON; break;
-                case ',': t.type = TOKEN_COMMA; break;
-                case '.': t.type = TOKEN_DOT; break;
-                case '=': t.type = TOKEN_ASSIGN; break;
-                case '<': t.type = TOKEN_LT; break;
-                case '>': t.type = TOKEN_GT; break;
-                case '?': t.type = TOKEN_QUESTION; break;
-                case ':': t.type = TOKEN_COLON; break;
-                case '!': t.type = TOKEN_NOT; break;
-                case '+': t.type = TOKEN_PLUS; break;
-                case '-': t.type = TOKEN_MINUS; break;
-                case '*': t.type = TOKEN_STAR; break;
-                case '/': t.type = TOKEN_SLASH; break;
-                case '%': t.type = TOKEN_MOD; break;
-                case '&': t.type = TOKEN_AMPERSAND; break;
-                default: t.type = TOKEN_EOF; break;
+                case '{': type = TOKEN_LBRACE; break;
+                case '}': type = TOKEN_RBRACE; break;
+                case '(': type = TOKEN_LPAREN; break;
+                case ')': type = TOKEN_RPAREN; break;
+                case '[': type = TOKEN_LBRACKET; break;
+                case ']': type = TOKEN_RBRACKET; break;
+                case ';': type = TOKEN_SEMICOLON; break;
+                case ',': type = TOKEN_COMMA; break;
+                case '.': type = TOKEN_DOT; break;
+                case '=': type = TOKEN_ASSIGN; break;
+                case '<': type = TOKEN_LT; break;
+                case '>': type = TOKEN_GT; break;
+                case '?': type = TOKEN_QUESTION; break;
+                case ':': type = TOKEN_COLON; break;
+                case '!': type = TOKEN_NOT; break;
+                case '+': type = TOKEN_PLUS; break;
+                case '-': type = TOKEN_MINUS; break;
+                case '*': type = TOKEN_STAR; break;
+                case '/': type = TOKEN_SLASH; break;
+                case '%': type = TOKEN_MOD; break;
+                case '&': type = TOKEN_AMPERSAND; break;
+                default: type = TOKEN_EOF; break;
             }
             i++;
+            push(type, start, 1);
         }
-        tokens.push_back(t);
     }
-    tokens.push_back({TOKEN_EOF, "", 0, line});
+    push(TOKEN_EOF, (int)source.length(), 0);
 }
 
-Token Interpreter::Peek(int offset) {
+const Token& Interpreter::Peek(int offset) const {
     if (currentToken + offset >= tokens.size()) return tokens.back();
     return tokens[currentToken + offset];
 }
-Token Interpreter::Consume() {
+const Token& Interpreter::Consume() {
     if (currentToken < tokens.size()) return tokens[currentToken++];
     return tokens.back();
 }
@@ -191,21 +467,31 @@ bool Interpreter::Match(TokenType type) {
     if (Peek().type == type) { Consume(); return true; }
     return false;
 }
-bool Interpreter::Check(TokenType type) { return Peek().type == type; }
+bool Interpreter::Check(TokenType type) const { return Peek().type == type; }
+std::string_view Interpreter::Text(const Token& t) const {
+    return std::string_view(source).substr(t.offset, t.length);
+}
 
 // --- Parser ---
 void Interpreter::ParseProgram() {
-    while (Peek().type != TOKEN_EOF) ParseGlobal();
+    std::vector<StmtId> globalDecls;
+    while (Peek().type != TOKEN_EOF) ParseGlobal(globalDecls);
+    
+    Stmt block(STMT_BLOCK);
+    block.block.first = ast.AddChildren(globalDecls);
+    block.block.count = (uint32_t)globalDecls.size();
+    globalInit.body = ast.Add(block);
 }
 
-void Interpreter::ParseGlobal() {
+void Interpreter::ParseGlobal(std::vector<StmtId>& globalDecls) {
+    int line = Peek().line;
     if (Match(TOKEN_STRUCT)) {
         StructDef def;
-        def.name = Consume().text;
+        def.name = Text(Consume());
         Match(TOKEN_LBRACE);
         while (!Check(TOKEN_RBRACE) && !Check(TOKEN_EOF)) {
-            std::string type = Consume().text;
-            std::string name = Consume().text;
+            std::string type(Text(Consume()));
+            std::string name(Text(Consume()));
             def.members[name] = type;
             Match(TOKEN_SEMICOLON);
         }
@@ -214,14 +500,23 @@ void Interpreter::ParseGlobal() {
         structs[def.name] = def;
     } else if (Match(TOKEN_ENUM)) {
         EnumDef def;
-        def.name = Consume().text;
+        def.name = Text(Consume());
         Match(TOKEN_LBRACE);
         int val = 0;
         do {
-            std::string name = Consume().text;
+            std::string name(Text(Consume()));
             if (Match(TOKEN_ASSIGN)) val = (int)Consume().numberValue;
             def.values[name] = val;
-            globals[name] = Value(val);
+            Expr lit(EXPR_LITERAL);
+            lit.literal.numberVal = (float)val;
+            lit.literal.intVal = val;
+            lit.literal.isInt = true;
+            Stmt decl(STMT_VAR_DECL);
+            decl.decl.type = ast.Intern("int");
+            decl.decl.name = ast.Intern(name);
+            decl.decl.initializer = ast.Add(lit);
+            decl.decl.isConst = true;
+            globalDecls.push_back(ast.Add(decl));
             val++;
         } while (Match(TOKEN_COMMA));
         Match(TOKEN_RBRACE);
@@ -229,9 +524,9 @@ void Interpreter::ParseGlobal() {
         enums[def.name] = def;
     } else {
         bool isConst = Match(TOKEN_CONST);
-        std::string type = Consume().text;
+        std::string type(Text(Consume()));
         bool isRef = Match(TOKEN_AMPERSAND); 
-        std::string name = Consume().text;
+        std::string name(Text(Consume()));
         
         if (Match(TOKEN_LPAREN)) {
             FunctionDef func;
@@ -241,9 +536,9 @@ void Interpreter::ParseGlobal() {
             
             if (!Check(TOKEN_RPAREN)) {
                 do {
-                    std::string pType = Consume().text;
+                    std::string pType(Text(Consume()));
                     bool pRef = Match(TOKEN_AMPERSAND);
-                    std::string pName = Consume().text;
+                    std::string pName(Text(Consume()));
                     if (pRef) pType += "&";
                     func.parameters.push_back({pType, pName});
                 } while (Match(TOKEN_COMMA));
@@ -251,302 +546,327 @@ void Interpreter::ParseGlobal() {
             Match(TOKEN_RPAREN);
             Match(TOKEN_LBRACE);
             
-            std::vector<StmtPtr> stmts;
+            std::vector<StmtId> stmts;
             while (!Check(TOKEN_RBRACE) && !Check(TOKEN_EOF)) {
                 stmts.push_back(ParseStatement());
             }
             Match(TOKEN_RBRACE);
             
-            auto block = std::make_shared<BlockStmt>();
-            block->statements = stmts;
-            func.body = block;
+            Stmt block(STMT_BLOCK);
+            block.block.first = ast.AddChildren(stmts);
+            block.block.count = (uint32_t)stmts.size();
+            func.body = ast.Add(block);
             functions[name] = func;
         } else {
+            Stmt decl(STMT_VAR_DECL);
+            decl.line = line;
+            decl.decl.type = ast.Intern(type);
+            decl.decl.name = ast.Intern(name);
+            decl.decl.isConst = isConst;
             if (Match(TOKEN_LBRACKET)) {
-                ExprPtr sizeExpr = ParseExpression();
+                decl.decl.isArray = true;
+                decl.decl.arraySize = ParseExpression();
                 Match(TOKEN_RBRACKET);
-                Match(TOKEN_SEMICOLON);
-                
-                Value sizeVal = Evaluate(sizeExpr);
-                Value arr;
-                arr.type = VAL_ARRAY;
-                Value defaultVal = CreateDefaultValue(type);
-                for(int i=0; i<sizeVal.intVal; i++) arr.arrayElements.push_back(defaultVal);
-                globals[name] = arr;
-            } else {
-                Value val = CreateDefaultValue(type);
-                if (Match(TOKEN_ASSIGN)) {
-                    val = Evaluate(ParseExpression());
-                }
-                globals[name] = val;
-                Match(TOKEN_SEMICOLON);
+            } else if (Match(TOKEN_ASSIGN)) {
+                decl.decl.initializer = ParseExpression();
             }
+            Match(TOKEN_SEMICOLON);
+            globalDecls.push_back(ast.Add(decl));
         }
     }
 }
 
-StmtPtr Interpreter::ParseStatement() {
+StmtId Interpreter::ParseStatement() {
     if (Check(TOKEN_LBRACE)) return ParseBlock();
+    int line = Peek().line;
+    auto add = [&](Stmt& stmt) {
+        stmt.line = line;
+        return ast.Add(stmt);
+    };
     if (Match(TOKEN_IF)) {
-        auto stmt = std::make_shared<IfStmt>();
+        Stmt stmt(STMT_IF);
         Match(TOKEN_LPAREN);
-        stmt->condition = ParseExpression();
+        stmt.ifStmt.condition = ParseExpression();
         Match(TOKEN_RPAREN);
-        stmt->thenBranch = ParseStatement();
-        if (Match(TOKEN_ELSE)) stmt->elseBranch = ParseStatement();
-        return stmt;
+        stmt.ifStmt.thenBranch = ParseStatement();
+        if (Match(TOKEN_ELSE)) stmt.ifStmt.elseBranch = ParseStatement();
+        return add(stmt);
     }
     if (Match(TOKEN_WHILE)) {
-        auto stmt = std::make_shared<WhileStmt>();
+        Stmt stmt(STMT_WHILE);
         Match(TOKEN_LPAREN);
-        stmt->condition = ParseExpression();
+        stmt.loop.condition = ParseExpression();
         Match(TOKEN_RPAREN);
-        stmt->body = ParseStatement();
-        return stmt;
+        stmt.loop.body = ParseStatement();
+        return add(stmt);
     }
     if (Match(TOKEN_DO)) {
-        auto stmt = std::make_shared<DoWhileStmt>();
-        stmt->body = ParseStatement();
+        Stmt stmt(STMT_DO_WHILE);
+        stmt.loop.body = ParseStatement();
         Match(TOKEN_WHILE);
         Match(TOKEN_LPAREN);
-        stmt->condition = ParseExpression();
+        stmt.loop.condition = ParseExpression();
         Match(TOKEN_RPAREN);
         Match(TOKEN_SEMICOLON);
-        return stmt;
+        return add(stmt);
     }
     if (Match(TOKEN_FOR)) {
-        auto stmt = std::make_shared<ForStmt>();
+        Stmt stmt(STMT_FOR);
         Match(TOKEN_LPAREN);
         if (!Check(TOKEN_SEMICOLON)) {
-            if (Check(TOKEN_INT) || Check(TOKEN_PILE) || structs.count(Peek().text)) {
+            if (Check(TOKEN_INT) || Check(TOKEN_PILE) || structs.count(Text(Peek()))) {
                  // Inline var decl
-                 auto decl = std::make_shared<VarDeclStmt>();
-                 decl->type = Consume().text;
+                 Stmt decl(STMT_VAR_DECL);
+                 std::string type(Text(Consume()));
                  bool isRef = Match(TOKEN_AMPERSAND);
-                 if (isRef) decl->type += "&";
-                 decl->name = Consume().text;
-                 if (Match(TOKEN_ASSIGN)) decl->initializer = ParseExpression();
+                 if (isRef) type += "&";
+                 decl.decl.type = ast.Intern(type);
+                 decl.decl.name = ast.Intern(Text(Consume()));
+                 if (Match(TOKEN_ASSIGN)) decl.decl.initializer = ParseExpression();
                  Match(TOKEN_SEMICOLON);
-                 stmt->init = decl;
+                 stmt.forStmt.init = add(decl);
             } else {
-                 auto exprStmt = std::make_shared<ExprStmt>();
-                 exprStmt->expression = ParseExpression();
+                 Stmt exprStmt(STMT_EXPR);
+                 exprStmt.expr.expression = ParseExpression();
                  Match(TOKEN_SEMICOLON);
-                 stmt->init = exprStmt;
+                 stmt.forStmt.init = add(exprStmt);
             }
         } else {
             Match(TOKEN_SEMICOLON);
         }
         
-        if (!Check(TOKEN_SEMICOLON)) stmt->condition = ParseExpression();
+        if (!Check(TOKEN_SEMICOLON)) stmt.forStmt.condition = ParseExpression();
         Match(TOKEN_SEMICOLON);
         
-        if (!Check(TOKEN_RPAREN)) stmt->increment = ParseExpression();
+        if (!Check(TOKEN_RPAREN)) stmt.forStmt.increment = ParseExpression();
         Match(TOKEN_RPAREN);
         
-        stmt->body = ParseStatement();
-        return stmt;
+        stmt.forStmt.body = ParseStatement();
+        return add(stmt);
     }
     if (Match(TOKEN_RETURN)) {
-        auto stmt = std::make_shared<ReturnStmt>();
-        if (!Check(TOKEN_SEMICOLON)) stmt->value = ParseExpression();
+        Stmt stmt(STMT_RETURN);
+        if (!Check(TOKEN_SEMICOLON)) stmt.ret.value = ParseExpression();
         Match(TOKEN_SEMICOLON);
-        return stmt;
+        return add(stmt);
     }
     
-    Token t = Peek();
+    const Token& t = Peek();
     bool isType = (t.type == TOKEN_INT || t.type == TOKEN_FLOAT || t.type == TOKEN_BOOL || t.type == TOKEN_LONG || t.type == TOKEN_PILE ||
-                   structs.count(t.text) || enums.count(t.text));
+                   structs.count(Text(t)) || enums.count(Text(t)));
     
     if (isType) {
-        auto stmt = std::make_shared<VarDeclStmt>();
-        stmt->type = Consume().text;
+        Stmt stmt(STMT_VAR_DECL);
+        std::string type(Text(Consume()));
         bool isRef = Match(TOKEN_AMPERSAND);
-        if (isRef) stmt->type += "&";
-        stmt->name = Consume().text;
+        if (isRef) type += "&";
+        stmt.decl.type = ast.Intern(type);
+        stmt.decl.name = ast.Intern(Text(Consume()));
         
         if (Match(TOKEN_LBRACKET)) {
-            stmt->isArray = true;
-            stmt->arraySize = ParseExpression();
+            stmt.decl.isArray = true;
+            stmt.decl.arraySize = ParseExpression();
             Match(TOKEN_RBRACKET);
         } else if (Match(TOKEN_ASSIGN)) {
-            stmt->initializer = ParseExpression();
+            stmt.decl.initializer = ParseExpression();
         }
         Match(TOKEN_SEMICOLON);
-        return stmt;
+        return add(stmt);
     }
     
-    auto stmt = std::make_shared<ExprStmt>();
-    stmt->expression = ParseExpression();
+    Stmt stmt(STMT_EXPR);
+    stmt.expr.expression = ParseExpression();
     Match(TOKEN_SEMICOLON);
-    return stmt;
+    return add(stmt);
 }
 
-StmtPtr Interpreter::ParseBlock() {
-    auto block = std::make_shared<BlockStmt>();
+StmtId Interpreter::ParseBlock() {
+    std::vector<StmtId> stmts;
+    int line = Peek().line;
     Match(TOKEN_LBRACE);
     while (!Check(TOKEN_RBRACE) && !Check(TOKEN_EOF)) {
-        block->statements.push_back(ParseStatement());
+        stmts.push_back(ParseStatement());
     }
     Match(TOKEN_RBRACE);
-    return block;
+    Stmt block(STMT_BLOCK);
+    block.line = line;
+    block.block.first = ast.AddChildren(stmts);
+    block.block.count = (uint32_t)stmts.size();
+    return ast.Add(block);
 }
 
-ExprPtr Interpreter::ParseExpression() { return ParseAssignment(); }
+ExprId Interpreter::MakeBinary(ExprId left, TokenType op, ExprId right) {
+    Expr binary(EXPR_BINARY);
+    binary.binary.left = left;
+    binary.binary.op = op;
+    binary.binary.right = right;
+    return ast.Add(binary);
+}
 
-ExprPtr Interpreter::ParseAssignment() {
-    ExprPtr expr = ParseLogicalOr();
+ExprId Interpreter::ParseExpression() { return ParseAssignment(); }
+
+ExprId Interpreter::ParseAssignment() {
+    ExprId expr = ParseLogicalOr();
     if (Match(TOKEN_ASSIGN)) {
-        auto assign = std::make_shared<AssignExpr>();
-        assign->target = expr;
-        assign->value = ParseAssignment();
-        return assign;
+        Expr assign(EXPR_ASSIGN);
+        assign.assign.target = expr;
+        assign.assign.value = ParseAssignment();
+        return ast.Add(assign);
     }
     return expr;
 }
 
-ExprPtr Interpreter::ParseLogicalOr() {
-    ExprPtr expr = ParseLogicalAnd();
+ExprId Interpreter::ParseLogicalOr() {
+    ExprId expr = ParseLogicalAnd();
     while (Match(TOKEN_OR)) {
-        auto binary = std::make_shared<BinaryExpr>();
-        binary->left = expr;
-        binary->op = TOKEN_OR;
-        binary->right = ParseLogicalAnd();
-        expr = binary;
+        ExprId right = ParseLogicalAnd();
+        expr = MakeBinary(expr, TOKEN_OR, right);
     }
     return expr;
 }
 
-ExprPtr Interpreter::ParseLogicalAnd() {
-    ExprPtr expr = ParseEquality();
+ExprId Interpreter::ParseLogicalAnd() {
+    ExprId expr = ParseEquality();
     while (Match(TOKEN_AND)) {
-        auto binary = std::make_shared<BinaryExpr>();
-        binary->left = expr;
-        binary->op = TOKEN_AND;
-        binary->right = ParseEquality();
-        expr = binary;
+        ExprId right = ParseEquality();
+        expr = MakeBinary(expr, TOKEN_AND, right);
     }
     return expr;
 }
 
-ExprPtr Interpreter::ParseEquality() {
-    ExprPtr expr = ParseRelational();
+ExprId Interpreter::ParseEquality() {
+    ExprId expr = ParseRelational();
     return expr;
 }
 
-ExprPtr Interpreter::ParseRelational() {
-    ExprPtr expr = ParseSum();
+ExprId Interpreter::ParseRelational() {
+    ExprId expr = ParseSum();
     while (Check(TOKEN_LT) || Check(TOKEN_GT)) {
-        auto binary = std::make_shared<BinaryExpr>();
-        binary->left = expr;
-        binary->op = Consume().type;
-        binary->right = ParseSum();
-        expr = binary;
+        TokenType op = Consume().type;
+        ExprId right = ParseSum();
+        expr = MakeBinary(expr, op, right);
     }
     return expr;
 }
 
-ExprPtr Interpreter::ParseSum() {
-    ExprPtr expr = ParseProduct();
+ExprId Interpreter::ParseSum() {
+    ExprId expr = ParseProduct();
     while (Check(TOKEN_PLUS) || Check(TOKEN_MINUS)) {
-        auto binary = std::make_shared<BinaryExpr>();
-        binary->left = expr;
-        binary->op = Consume().type;
-        binary->right = ParseProduct();
-        expr = binary;
+        TokenType op = Consume().type;
+        ExprId right = ParseProduct();
+        expr = MakeBinary(expr, op, right);
     }
     return expr;
 }
 
-ExprPtr Interpreter::ParseProduct() {
-    ExprPtr expr = ParseUnary();
+ExprId Interpreter::ParseProduct() {
+    ExprId expr = ParseUnary();
     while (Check(TOKEN_STAR) || Check(TOKEN_SLASH) || Check(TOKEN_MOD)) {
-        auto binary = std::make_shared<BinaryExpr>();
-        binary->left = expr;
-        binary->op = Consume().type;
-        binary->right = ParseUnary();
-        expr = binary;
+        TokenType op = Consume().type;
+        ExprId right = ParseUnary();
+        expr = MakeBinary(expr, op, right);
     }
     return expr;
 }
 
-ExprPtr Interpreter::ParseUnary() {
+ExprId Interpreter::ParseUnary() {
     if (Check(TOKEN_NOT) || Check(TOKEN_MINUS)) {
-        auto unary = std::make_shared<UnaryExpr>();
-        unary->op = Consume().type;
-        unary->right = ParseUnary();
-        return unary;
+        Expr unary(EXPR_UNARY);
+        unary.unary.op = Consume().type;
+        unary.unary.right = ParseUnary();
+        return ast.Add(unary);
     }
-    if (Check(TOKEN_INC) || Check(TOKEN_DEC)) {
-        auto unary = std::make_shared<UnaryExpr>();
-        unary->op = Consume().type;
-        unary->right = ParseUnary();
-        return unary;
+    if (Check(TOKEN_INC) || Check(TOKEN_DEC) || Check(TOKEN_AMPERSAND)) {
+        Expr unary(EXPR_UNARY);
+        unary.unary.op = Consume().type;
+        unary.unary.right = ParseUnary();
+        return ast.Add(unary);
     }
     return ParsePrimary();
 }
 
-ExprPtr Interpreter::ParsePrimary() {
-    ExprPtr expr = nullptr;
+ExprId Interpreter::ParsePrimary() {
+    ExprId expr = kNoNode;
     
-    if (Match(TOKEN_TRUE)) { auto l = std::make_shared<LiteralExpr>(); l->boolVal = true; l->isBool = true; expr = l; }
-    else if (Match(TOKEN_FALSE)) { auto l = std::make_shared<LiteralExpr>(); l->boolVal = false; l->isBool = true; expr = l; }
+    if (Match(TOKEN_TRUE)) { Expr l(EXPR_LITERAL); l.literal.boolVal = true; l.literal.isBool = true; expr = ast.Add(l); }
+    else if (Match(TOKEN_FALSE)) { Expr l(EXPR_LITERAL); l.literal.boolVal = false; l.literal.isBool = true; expr = ast.Add(l); }
     else if (Check(TOKEN_NUMBER)) {
-        auto l = std::make_shared<LiteralExpr>();
-        l->numberVal = Consume().numberValue;
-        expr = l;
+        const Token& t = Consume();
+        Expr l(EXPR_LITERAL);
+        l.literal.numberVal = t.numberValue;
+        std::string_view text = Text(t);
+        if (text.find('.') == std::string_view::npos) {
+            // Integer literals keep all 32 bits; numberValue is only a float
+            long long v = 0;
+            for (char c : text) v = v * 10 + (c - '0');
+            l.literal.intVal = (int)(uint32_t)v;
+            l.literal.isInt = true;
+        }
+        expr = ast.Add(l);
     }
     else if (Check(TOKEN_ID)) {
-        std::string name = Consume().text;
+        std::string_view name = Text(Consume());
         if (Match(TOKEN_LPAREN)) {
-            auto call = std::make_shared<CallExpr>();
-            call->callee = name;
+            std::vector<ExprId> args;
             if (!Check(TOKEN_RPAREN)) {
                 do {
-                    call->args.push_back(ParseExpression());
+                    args.push_back(ParseExpression());
                 } while (Match(TOKEN_COMMA));
             }
             Match(TOKEN_RPAREN);
-            expr = call;
+            Expr call(EXPR_CALL);
+            call.call.callee = ast.Intern(name);
+            call.call.firstArg = ast.AddChildren(args);
+            call.call.argCount = (uint32_t)args.size();
+            call.call.function = -1;
+            call.call.builtin = -1;
+            expr = ast.Add(call);
         } else {
-            auto var = std::make_shared<VariableExpr>();
-            var->name = name;
-            expr = var;
+            Expr var(EXPR_VARIABLE);
+            var.variable.name = ast.Intern(name);
+            var.variable.slot = -1;
+            expr = ast.Add(var);
         }
     }
     else if (Match(TOKEN_LPAREN)) {
-        Token t = Peek();
-        bool isType = (t.type == TOKEN_INT || t.type == TOKEN_FLOAT || enums.count(t.text));
+        const Token& t = Peek();
+        bool isType = (t.type == TOKEN_INT || t.type == TOKEN_LONG || t.type == TOKEN_FLOAT || t.type == TOKEN_BOOL ||
+                       enums.count(Text(t)));
         if (isType) {
-            Consume(); 
+            // Cast: a conversion unary keyed by the target type's token
+            TokenType target = Consume().type;
+            if (target != TOKEN_FLOAT && target != TOKEN_BOOL) target = TOKEN_INT;
             Match(TOKEN_RPAREN);
-            expr = ParseUnary();
+            Expr cast(EXPR_UNARY);
+            cast.unary.op = target;
+            cast.unary.right = ParseUnary();
+            expr = ast.Add(cast);
         } else {
             expr = ParseExpression();
             Match(TOKEN_RPAREN);
         }
     }
     
-    if (!expr) expr = std::make_shared<LiteralExpr>();
+    if (expr == kNoNode) expr = ast.Add(Expr(EXPR_LITERAL));
     
     // Handle suffixes
     while (true) {
         if (Match(TOKEN_DOT)) {
-            auto member = std::make_shared<MemberExpr>();
-            member->object = expr;
-            member->member = Consume().text;
-            expr = member;
+            Expr member(EXPR_MEMBER);
+            member.member.object = expr;
+            member.member.member = ast.Intern(Text(Consume()));
+            expr = ast.Add(member);
         } else if (Match(TOKEN_LBRACKET)) {
-            auto index = std::make_shared<IndexExpr>();
-            index->array = expr;
-            index->index = ParseExpression();
+            Expr index(EXPR_INDEX);
+            index.index.array = expr;
+            index.index.index = ParseExpression();
             Match(TOKEN_RBRACKET);
-            expr = index;
+            expr = ast.Add(index);
         } else if (Check(TOKEN_INC) || Check(TOKEN_DEC)) {
-            auto postfix = std::make_shared<PostfixExpr>();
-            postfix->left = expr;
-            postfix->op = Consume().type;
-            expr = postfix;
+            Expr postfix(EXPR_POSTFIX);
+            postfix.postfix.left = expr;
+            postfix.postfix.op = Consume().type;
+            expr = ast.Add(postfix);
         } else {
             break;
         }
@@ -554,410 +874,16 @@ ExprPtr Interpreter::ParsePrimary() {
     return expr;
 }
 
-// --- Execution ---
-
-Value* Interpreter::GetLValue(ExprPtr expr) {
-    if (auto var = std::dynamic_pointer_cast<VariableExpr>(expr)) {
-        if (!callStack.empty()) {
-            auto& locals = callStack.back().locals;
-            if (locals.count(var->name)) return &locals[var->name];
-        }
-        if (globals.count(var->name)) return &globals[var->name];
-    } else if (auto member = std::dynamic_pointer_cast<MemberExpr>(expr)) {
-        Value* obj = GetLValue(member->object);
-        if (obj) {
-            if (obj->type == VAL_REF && obj->refVal) obj = obj->refVal;
-            return &obj->members[member->member];
-        }
-    } else if (auto index = std::dynamic_pointer_cast<IndexExpr>(expr)) {
-        Value* arr = GetLValue(index->array);
-        Value idx = Evaluate(index->index);
-        if (arr) {
-            if (arr->type == VAL_REF && arr->refVal) arr = arr->refVal;
-            if (idx.intVal >= 0 && idx.intVal < arr->arrayElements.size()) {
-                return &arr->arrayElements[idx.intVal];
-            }
-        }
-    }
-    return nullptr;
-}
-
-Value Interpreter::Evaluate(ExprPtr expr) {
-    if (auto l = std::dynamic_pointer_cast<LiteralExpr>(expr)) {
-        if (l->isBool) return Value(l->boolVal);
-        return Value(l->numberVal);
-    }
-    if (auto v = std::dynamic_pointer_cast<VariableExpr>(expr)) {
-        Value* val = GetLValue(expr);
-        if (val) {
-            if (val->type == VAL_REF && val->refVal) return *val->refVal;
-            return *val;
-        }
-        return Value();
-    }
-    if (auto a = std::dynamic_pointer_cast<AssignExpr>(expr)) {
-        Value* target = GetLValue(a->target);
-        Value val = Evaluate(a->value);
-        if (target) {
-            if (target->type == VAL_REF && target->refVal) {
-                *target->refVal = val;
-            } else {
-                *target = val;
-            }
-        }
-        return val;
-    }
-    if (auto b = std::dynamic_pointer_cast<BinaryExpr>(expr)) {
-        Value left = Evaluate(b->left);
-        Value right = Evaluate(b->right);
-        
-        if (b->op == TOKEN_PLUS) return Value(left.floatVal + right.floatVal);
-        if (b->op == TOKEN_MINUS) return Value(left.floatVal - right.floatVal);
-        if (b->op == TOKEN_STAR) return Value(left.floatVal * right.floatVal);
-        if (b->op == TOKEN_SLASH) return Value(right.floatVal != 0 ? left.floatVal / right.floatVal : 0);
-        if (b->op == TOKEN_MOD) return Value((int)left.floatVal % (int)right.floatVal);
-        
-        if (b->op == TOKEN_LT) return Value(left.floatVal < right.floatVal);
-        if (b->op == TOKEN_GT) return Value(left.floatVal > right.floatVal);
-        if (b->op == TOKEN_AND) return Value(left.boolVal && right.boolVal);
-        if (b->op == TOKEN_OR) return Value(left.boolVal || right.boolVal);
-    }
-    if (auto u = std::dynamic_pointer_cast<UnaryExpr>(expr)) {
-        if (u->op == TOKEN_NOT) return Value(!Evaluate(u->right).boolVal);
-        if (u->op == TOKEN_MINUS) return Value(-Evaluate(u->right).floatVal);
-        if (u->op == TOKEN_INC || u->op == TOKEN_DEC) {
-            Value* val = GetLValue(u->right);
-            if (val) {
-                if (val->type == VAL_REF && val->refVal) val = val->refVal;
-                if (u->op == TOKEN_INC) {
-                    val->intVal++; val->floatVal++;
-                } else {
-                    val->intVal--; val->floatVal--;
-                }
-                return *val;
-            }
-        }
-    }
-    if (auto p = std::dynamic_pointer_cast<PostfixExpr>(expr)) {
-        Value* val = GetLValue(p->left);
-        if (val) {
-            if (val->type == VAL_REF && val->refVal) val = val->refVal;
-            Value old = *val;
-            if (p->op == TOKEN_INC) {
-                val->intVal++; val->floatVal++;
-            } else {
-                val->intVal--; val->floatVal--;
-            }
-            return old;
-        }
-    }
-    if (auto c = std::dynamic_pointer_cast<CallExpr>(expr)) {
-        std::vector<Value> args;
-        for (auto arg : c->args) args.push_back(Evaluate(arg));
-        return CallFunction(c->callee, args);
-    }
-    if (auto m = std::dynamic_pointer_cast<MemberExpr>(expr)) {
-        Value* obj = GetLValue(m->object);
-        if (obj) {
-            if (obj->type == VAL_REF && obj->refVal) obj = obj->refVal;
-            return obj->members[m->member];
-        }
-    }
-    if (auto i = std::dynamic_pointer_cast<IndexExpr>(expr)) {
-        Value* arr = GetLValue(i->array);
-        Value idx = Evaluate(i->index);
-        if (arr) {
-            if (arr->type == VAL_REF && arr->refVal) arr = arr->refVal;
-            if (idx.intVal >= 0 && idx.intVal < arr->arrayElements.size()) {
-                return arr->arrayElements[idx.intVal];
-            }
-        }
-    }
-    return Value();
-}
-
-void Interpreter::Execute(StmtPtr stmt) {
-    if (!stmt) return;
-    if (!isRunning) return; // Stop check
-    if (!callStack.empty() && callStack.back().returnHit) return;
-    
-    if (auto block = std::dynamic_pointer_cast<BlockStmt>(stmt)) {
-        for (auto s : block->statements) Execute(s);
-    } else if (auto ifStmt = std::dynamic_pointer_cast<IfStmt>(stmt)) {
-        Value cond = Evaluate(ifStmt->condition);
-        if (cond.boolVal || cond.intVal != 0) Execute(ifStmt->thenBranch);
-        else if (ifStmt->elseBranch) Execute(ifStmt->elseBranch);
-    } else if (auto whileStmt = std::dynamic_pointer_cast<WhileStmt>(stmt)) {
-        while (isRunning) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(1));
-            Value cond = Evaluate(whileStmt->condition);
-            if (!cond.boolVal && cond.intVal == 0) break;
-            Execute(whileStmt->body);
-            if (!callStack.empty() && callStack.back().returnHit) break;
-        }
-    } else if (auto doStmt = std::dynamic_pointer_cast<DoWhileStmt>(stmt)) {
-        do {
-            std::this_thread::sleep_for(std::chrono::milliseconds(1));
-            Execute(doStmt->body);
-            if (!callStack.empty() && callStack.back().returnHit) break;
-            Value cond = Evaluate(doStmt->condition);
-            if (!cond.boolVal && cond.intVal == 0) break;
-        } while (isRunning);
-    } else if (auto forStmt = std::dynamic_pointer_cast<ForStmt>(stmt)) {
-        if (forStmt->init) Execute(forStmt->init);
-        while (isRunning) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(1));
-            if (forStmt->condition) {
-                Value cond = Evaluate(forStmt->condition);
-                if (!cond.boolVal && cond.intVal == 0) break;
-            }
-            Execute(forStmt->body);
-            if (!callStack.empty() && callStack.back().returnHit) break;
-            if (forStmt->increment) Evaluate(forStmt->increment);
-        }
-    } else if (auto ret = std::dynamic_pointer_cast<ReturnStmt>(stmt)) {
-        if (!callStack.empty()) {
-            callStack.back().returnHit = true;
-            if (ret->value) {
-                std::string funcName = callStack.back().functionName;
-                if (functions.count(funcName) && functions[funcName].returnType.back() == '&') {
-                    Value* ptr = GetLValue(ret->value);
-                    if (ptr) {
-                        if (ptr->type == VAL_REF && ptr->refVal) ptr = ptr->refVal;
-                        Value refVal;
-                        refVal.type = VAL_REF;
-                        refVal.refVal = ptr;
-                        callStack.back().returnValue = refVal;
-                    }
-                } else {
-                    callStack.back().returnValue = Evaluate(ret->value);
-                }
-            }
-        }
-    } else if (auto expr = std::dynamic_pointer_cast<ExprStmt>(stmt)) {
-        Evaluate(expr->expression);
-    } else if (auto decl = std::dynamic_pointer_cast<VarDeclStmt>(stmt)) {
-        Value val;
-        if (decl->isArray) {
-            val.type = VAL_ARRAY;
-            Value size = Evaluate(decl->arraySize);
-            Value def = CreateDefaultValue(decl->type);
-            for(int i=0; i<size.intVal; i++) val.arrayElements.push_back(def);
-        } else {
-            if (decl->initializer) {
-                Value initVal = Evaluate(decl->initializer);
-                if (decl->type.back() == '&') {
-                    if (initVal.type == VAL_REF) {
-                        val.type = VAL_REF;
-                        val.refVal = initVal.refVal;
-                    }
-                } else {
-                    if (initVal.type == VAL_REF && initVal.refVal) val = *initVal.refVal;
-                    else val = initVal;
-                }
-            } else {
-                val = CreateDefaultValue(decl->type);
-            }
-        }
-        if (decl->type == "pile") val.type = VAL_PILE;
-        if (!callStack.empty()) callStack.back().locals[decl->name] = val;
-    }
-}
-
-Value Interpreter::CallFunction(const std::string& name, const std::vector<Value>& args) {
-    if (name == "digitalWrite") {
-        if (args.size() == 2) SetPinValue(args[0].intVal, args[1].intVal);
-        return Value();
-    }
-    if (name == "delay") {
-        if (args.size() >= 1) {
-            int ms = args[0].intVal;
-            std::this_thread::sleep_for(std::chrono::milliseconds(ms));
-        }
-        return Value();
-    }
-    if (name == "delayMicroseconds") {
-        if (args.size() >= 1) {
-            int us = args[0].intVal;
-            std::this_thread::sleep_for(std::chrono::microseconds(us));
-        }
-        return Value();
-    }
-    if (name == "pulseIn") {
-        if (args.size() >= 1) {
-            int echo = args[0].intVal;
-            std::lock_guard<std::mutex> lock(memoryMutex);
-            if (sensorValues.count(echo)) {
-                float dist = sensorValues[echo];
-                float duration = dist * 2.0f / 0.034f;
-                return Value(duration);
-            }
-        }
-        return Value(0);
-    }
-    
-    if (name == "push") {
-        if (args.size() == 2) {
-             // args[0] should be pile ref, args[1] int
-             Value* pPile = nullptr;
-             // We need to find the variable in memory. 
-             // But args are passed by value. 
-             // We need to change CallFunction to accept references or handle pile specifically.
-             // Actually, for "push(p, 10)", p is passed as Value.
-             // If p is VAL_PILE, it's a copy. That's bad.
-             // We need pass-by-reference for piles.
-             // But the user just writes "push(p, 10)".
-             // In our language, we should make pile implicitly a reference or handle it.
-             // For now, let's assume the user passes a reference or we find it.
-             // Wait, `CallFunction` receives `vector<Value>`.
-             // If `p` was a variable, `Evaluate` returned its value (copy).
-             // Unless we change `Evaluate` to return references for piles?
-             // Or we make `push` a special case in `ParsePrimary`?
-             // Or we just say `pile` is a reference type?
-             
-             // Let's hack it: `push` is a built-in that modifies the pile.
-             // But we only have the copy here.
-             // This requires a deeper change to support pass-by-reference for built-ins or 
-             // change how `push` is called.
-             
-             // Alternative: `p.push(10)`.
-             // Then `MemberExpr` -> `CallExpr`.
-             // `Evaluate` for `MemberExpr` could handle methods.
-             
-             // Let's try to find the pile in the stack if it's a local variable?
-             // No, that's messy.
-             
-             // Let's assume `pile` is a reference type (like arrays often are in some langs).
-             // When we assign `pile p;`, we create the object.
-             // When we pass `p`, we pass a reference.
-             // In `Evaluate(VariableExpr)`, if it's a pile, return a REF value?
-             
-             // Let's modify `Evaluate` for `VariableExpr`:
-             // If it's a pile, return a REF?
-             // No, `Value` has `pileElements`.
-             
-             // Let's just make `push` and `pop` macros or special forms?
-             // No.
-             
-             // Let's check `Interpreter::Evaluate` for `VariableExpr`.
-             // It returns `*val`.
-             
-             // If I change `Value` to hold a shared_ptr to pile data?
-             // That would solve it.
-             // But `Value` is a struct.
-             
-             // Let's look at `VAL_REF`.
-             // If I pass `&p` to `push`, it works. `push(&p, 10)`.
-             // User wants `push(p, 10)`?
-             // If so, I need to change `Evaluate` to return REF for piles, OR change `push` to take `&p`.
-             // Let's stick to `push(&p, 10)` for now as it's C++-like, 
-             // OR implement `p.push(10)`.
-             
-             // User asked for "piles push and pop functions".
-             // `push(p, 10)` is standard.
-             // I will assume `push` takes a reference.
-             // So user must write `push(&p, 10)`.
-             // OR, I can make `pile` always be a reference.
-             
-             // Let's go with `push(&p, 10)` for safety, or better:
-             // Change `Value` to use `std::shared_ptr<vector<int>>` for piles.
-             // That way copies share the data.
-             // I'll do that in `Interpreter.h`? No, too many changes.
-             
-             // I'll implement `push` to expect a REF.
-             if (args[0].type == VAL_REF && args[0].refVal && args[0].refVal->type == VAL_PILE) {
-                 args[0].refVal->pileElements.push_back(args[1].intVal);
-             }
-        }
-        return Value();
-    }
-    if (name == "pop") {
-        if (args.size() == 1) {
-             if (args[0].type == VAL_REF && args[0].refVal && args[0].refVal->type == VAL_PILE) {
-                 if (!args[0].refVal->pileElements.empty()) {
-                     int v = args[0].refVal->pileElements.back();
-                     args[0].refVal->pileElements.pop_back();
-                     return Value(v);
-                 }
-             }
-        }
-        return Value(0);
-    }
-
-    // Movement Built-ins
-    if (name == "forward") {
-        SetPinValue(8, 1); SetPinValue(9, 0);
-        SetPinValue(10, 1); SetPinValue(11, 0);
-        return Value();
-    }
-    if (name == "backward") {
-        SetPinValue(8, 0); SetPinValue(9, 1);
-        SetPinValue(10, 0); SetPinValue(11, 1);
-        return Value();
-    }
-    if (name == "left") {
-        // Rotate 90 degrees left
-        // Simulate by turning in place for a specific time
-        SetPinValue(8, 0); SetPinValue(9, 1); // Left Bwd
-        SetPinValue(10, 1); SetPinValue(11, 0); // Right Fwd
-        std::this_thread::sleep_for(std::chrono::milliseconds(400)); // Calibrated delay
-        SetPinValue(8, 0); SetPinValue(9, 0);
-        SetPinValue(10, 0); SetPinValue(11, 0);
-        return Value();
-    }
-    if (name == "right") {
-        // Rotate 90 degrees right
-        SetPinValue(8, 1); SetPinValue(9, 0); // Left Fwd
-        SetPinValue(10, 0); SetPinValue(11, 1); // Right Bwd
-        std::this_thread::sleep_for(std::chrono::milliseconds(400)); // Calibrated delay
-        SetPinValue(8, 0); SetPinValue(9, 0);
-        SetPinValue(10, 0); SetPinValue(11, 0);
-        return Value();
-    }
-    if (name == "stop") {
-        SetPinValue(8, 0); SetPinValue(9, 0);
-        SetPinValue(10, 0); SetPinValue(11, 0);
-        return Value();
-    }
-
-    if (name == "pinMode") return Value();
-    if (name == "Serial.begin") return Value();
-    
-    if (functions.count(name)) {
-        FunctionDef& func = functions[name];
-        StackFrame frame;
-        frame.functionName = name;
-        
-        for (size_t i = 0; i < func.parameters.size() && i < args.size(); i++) {
-            std::string pName = func.parameters[i].second;
-            std::string pType = func.parameters[i].first;
-            
-            if (pType.back() == '&') {
-                frame.locals[pName] = args[i];
-            } else {
-                frame.locals[pName] = args[i];
-            }
-        }
-        
-        callStack.push_back(frame);
-        Execute(func.body);
-        Value ret = callStack.back().returnValue;
-        callStack.pop_back();
-        return ret;
-    }
-    return Value();
-}
-
 Value Interpreter::CreateDefaultValue(const std::string& type) {
     if (type == "int" || type == "long") return Value(0);
     if (type == "float") return Value(0.0f);
     if (type == "bool") return Value(false);
+    if (type == "pile") return Value::MakeAggregate(VAL_PILE);
     if (structs.count(type)) {
-        Value v;
-        v.type = VAL_STRUCT;
-        v.structName = type;
+        Value v = Value::MakeAggregate(VAL_STRUCT);
+        v.object->structName = type;
         for (auto& member : structs[type].members) {
-            v.members[member.first] = CreateDefaultValue(member.second);
+            v.object->members[member.first] = CreateDefaultValue(member.second);
         }
         return v;
     }
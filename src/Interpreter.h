@@ -1,12 +1,20 @@
 #pragma once
 #include <string>
+#include <string_view>
+#include <deque>
 #include <vector>
 #include <map>
-#include <memory>
+#include <set>
+#include <iosfwd>
+#include <unordered_map>
 #include <functional>
 #include <thread>
 #include <mutex>
 #include <atomic>
+#include <cstdint>
+#include "Bytecode.h"
+#include "PinBank.h"
+#include "SimClock.h"
 
 enum TokenType {
     TOKEN_EOF, TOKEN_ID, TOKEN_NUMBER,
@@ -22,119 +30,234 @@ enum TokenType {
     TOKEN_INC, TOKEN_DEC,
     TOKEN_TRUE, TOKEN_FALSE, TOKEN_AMPERSAND
 };
+static const int kTokenTypeCount = TOKEN_AMPERSAND + 1; // Keep in step with the last token
 
 struct Token {
     TokenType type;
-    std::string text;
-    float numberValue;
+    uint32_t offset;     // Text is source[offset, offset + length)
+    uint32_t length;
     int line;
+    float numberValue;   // TOKEN_NUMBER
 };
 
 // --- AST ---
+// Nodes live in contiguous per-program arrays owned by Ast and refer to each
+// other by 32-bit index. Index 0 of each array is a placeholder, so a zero id
+// means "no node". Load() drops the whole tree with one Ast::Clear().
+
+typedef uint32_t StmtId;
+typedef uint32_t ExprId;
+typedef uint32_t NameId; // Interned identifier or type name, see Ast::names
+static const uint32_t kNoNode = 0;
+
+enum StmtKind {
+    STMT_BLOCK, STMT_IF, STMT_WHILE, STMT_DO_WHILE, STMT_FOR,
+    STMT_RETURN, STMT_EXPR, STMT_VAR_DECL
+};
+static const int kStmtKindCount = STMT_VAR_DECL + 1; // Keep in step with the last kind
 
-struct Stmt;
-struct Expr;
+enum ExprKind : uint8_t {
+    EXPR_BINARY, EXPR_UNARY, EXPR_POSTFIX, EXPR_LITERAL, EXPR_VARIABLE,
+    EXPR_CALL, EXPR_MEMBER, EXPR_INDEX, EXPR_ASSIGN
+};
+static const int kExprKindCount = EXPR_ASSIGN + 1; // Keep in step with the last kind
 
-typedef std::shared_ptr<Stmt> StmtPtr;
-typedef std::shared_ptr<Expr> ExprPtr;
+// Static type of an expression, inferred from declarations by the resolver.
+// int/long and enums are TYPE_INT (32-bit); anything else, including
+// aggregates and builtins of unknown result, is TYPE_UNKNOWN and uses the
+// generic float operations.
+enum StaticType : uint8_t { TYPE_UNKNOWN, TYPE_INT, TYPE_FLOAT, TYPE_BOOL };
 
-struct Stmt {
-    virtual ~Stmt() = default;
+// Statements
+struct BlockStmt {
+    uint32_t first;      // Statements are Ast::children[first, first + count)
+    uint32_t count;
 };
 
-struct Expr {
-    virtual ~Expr() = default;
+struct IfStmt {
+    ExprId condition;
+    StmtId thenBranch;
+    StmtId elseBranch;
 };
 
-// Statements
-struct BlockStmt : Stmt {
-    std::vector<StmtPtr> statements;
+struct WhileStmt {       // STMT_WHILE and STMT_DO_WHILE
+    ExprId condition;
+    StmtId body;
 };
 
-struct IfStmt : Stmt {
-    ExprPtr condition;
-    StmtPtr thenBranch;
-    StmtPtr elseBranch;
+struct ForStmt {
+    StmtId init;
+    ExprId condition;
+    ExprId increment;
+    StmtId body;
 };
 
-struct WhileStmt : Stmt {
-    ExprPtr condition;
-    StmtPtr body;
+struct ReturnStmt {
+    ExprId value;
 };
 
-struct DoWhileStmt : Stmt {
-    StmtPtr body;
-    ExprPtr condition;
+struct ExprStmt {
+    ExprId expression;
 };
 
-struct ForStmt : Stmt {
-    StmtPtr init;
-    ExprPtr condition;
-    ExprPtr increment;
-    StmtPtr body;
+struct VarDeclStmt {
+    NameId type;         // Ends in '&' for reference declarations
+    NameId name;
+    ExprId initializer;
+    ExprId arraySize;
+    bool isArray;
+    bool isConst;        // Global `const` or enum value; the optimizer may propagate it
+    int slot;            // Frame slot, or global index for globals
 };
 
-struct ReturnStmt : Stmt {
-    ExprPtr value;
+// Expressions
+struct BinaryExpr {
+    ExprId left;
+    TokenType op;
+    ExprId right;
 };
 
-struct ExprStmt : Stmt {
-    ExprPtr expression;
+struct UnaryExpr {
+    TokenType op;        // TOKEN_INT / TOKEN_FLOAT / TOKEN_BOOL: conversion, e.g. `(int)x`
+    ExprId right;
 };
 
-struct VarDeclStmt : Stmt {
-    std::string type;
-    std::string name;
-    ExprPtr initializer;
-    bool isArray = false;
-    ExprPtr arraySize;
+struct PostfixExpr {
+    ExprId left;
+    TokenType op;
 };
 
-// Expressions
-struct BinaryExpr : Expr {
-    ExprPtr left;
-    TokenType op;
-    ExprPtr right;
+struct LiteralExpr {
+    float numberVal;     // Also set for integer literals
+    int intVal;          // isInt
+    bool boolVal;        // isBool
+    bool isBool;
+    bool isInt;          // Number written without a decimal point
 };
 
-struct UnaryExpr : Expr {
-    TokenType op;
-    ExprPtr right;
+struct VariableExpr {
+    NameId name;
+    int slot;            // Set by Interpreter::Resolve; -1 if undeclared
+    bool isGlobal;
 };
 
-struct PostfixExpr : Expr {
-    ExprPtr left;
-    TokenType op;
+struct CallExpr {
+    NameId callee;
+    uint32_t firstArg;   // Arguments are Ast::children[firstArg, firstArg + argCount)
+    uint32_t argCount;
+    int function;        // Set by Interpreter::Resolve: functionTable index ...
+    int builtin;         // ... or builtin table index, -1 if neither
 };
 
-struct LiteralExpr : Expr {
-    float numberVal;
-    bool boolVal;
-    bool isBool = false;
+struct MemberExpr {
+    ExprId object;
+    NameId member;
 };
 
-struct VariableExpr : Expr {
-    std::string name;
+struct IndexExpr {
+    ExprId array;
+    ExprId index;
 };
 
-struct CallExpr : Expr {
-    std::string callee;
-    std::vector<ExprPtr> args;
+struct AssignExpr {
+    ExprId target;
+    ExprId value;
 };
 
-struct MemberExpr : Expr {
-    ExprPtr object;
-    std::string member;
+struct Stmt {
+    StmtKind kind;
+    int line = 0;        // Source line the statement starts on, for runtime errors
+    union {
+        uint32_t raw[6];
+        BlockStmt block;
+        IfStmt ifStmt;
+        WhileStmt loop;
+        ForStmt forStmt;
+        ReturnStmt ret;
+        ExprStmt expr;
+        VarDeclStmt decl;
+    };
+    explicit Stmt(StmtKind k) : kind(k), raw() {}
 };
 
-struct IndexExpr : Expr {
-    ExprPtr array;
-    ExprPtr index;
+struct Expr {
+    ExprKind kind;
+    StaticType type = TYPE_UNKNOWN; // Set by Interpreter::Resolve
+    union {
+        uint32_t raw[5];
+        BinaryExpr binary;
+        UnaryExpr unary;
+        PostfixExpr postfix;
+        LiteralExpr literal;
+        VariableExpr variable;
+        CallExpr call;
+        MemberExpr member;
+        IndexExpr index;
+        AssignExpr assign;
+    };
+    explicit Expr(ExprKind k) : kind(k), raw() {}
 };
 
-struct AssignExpr : Expr {
-    ExprPtr target;
-    ExprPtr value;
+static_assert(sizeof(Stmt) == 32 && sizeof(Expr) == 24, "AST payloads must fit in raw[]");
+
+class Ast {
+public:
+    std::vector<Stmt> stmts;
+    std::vector<Expr> exprs;
+    std::vector<uint32_t> children; // Block statements and call arguments, one contiguous run each
+    std::deque<std::string> names;  // Deque: nameIds keys point into these strings
+
+    Ast() { Clear(); }
+    // nameIds views the strings in `names`, so a copy indexes its own
+    Ast(const Ast& other)
+        : stmts(other.stmts), exprs(other.exprs), children(other.children), names(other.names) {
+        IndexNames();
+    }
+    Ast& operator=(const Ast& other) {
+        stmts = other.stmts;
+        exprs = other.exprs;
+        children = other.children;
+        names = other.names;
+        IndexNames();
+        return *this;
+    }
+
+    // Drops every node; the arrays keep their capacity for the next program
+    void Clear() {
+        stmts.clear();
+        exprs.clear();
+        children.clear();
+        names.clear();
+        nameIds.clear();
+        stmts.push_back(Stmt(STMT_BLOCK));
+        exprs.push_back(Expr(EXPR_LITERAL));
+    }
+
+    StmtId Add(const Stmt& s) { stmts.push_back(s); return (StmtId)stmts.size() - 1; }
+    ExprId Add(const Expr& e) { exprs.push_back(e); return (ExprId)exprs.size() - 1; }
+    uint32_t AddChildren(const std::vector<uint32_t>& ids) {
+        uint32_t first = (uint32_t)children.size();
+        children.insert(children.end(), ids.begin(), ids.end());
+        return first;
+    }
+
+    NameId Intern(std::string_view name) {
+        auto it = nameIds.find(name);
+        if (it != nameIds.end()) return it->second;
+        NameId id = (NameId)names.size();
+        names.emplace_back(name);
+        nameIds[names.back()] = id;
+        return id;
+    }
+    const std::string& Name(NameId id) const { return names[id]; }
+
+private:
+    std::unordered_map<std::string_view, NameId> nameIds;
+
+    void IndexNames() {
+        nameIds.clear();
+        for (NameId id = 0; id < (NameId)names.size(); id++) nameIds[names[id]] = id;
+    }
 };
 
 // --- Definitions ---
@@ -143,7 +266,10 @@ struct FunctionDef {
     std::string name;
     std::string returnType;
     std::vector<std::pair<std::string, std::string>> parameters;
-    StmtPtr body;
+    StmtId body = kNoNode;
+    int entry = -1; // Offset of the compiled body in Interpreter::code
+    int localCount = 0; // Frame slots: parameters first, then declarations
+    int index = -1;     // Position in Interpreter::functionTable
 };
 
 struct StructDef {
@@ -158,100 +284,444 @@ struct EnumDef {
 
 // --- Runtime Values ---
 
-enum ValueType { VAL_VOID, VAL_INT, VAL_FLOAT, VAL_BOOL, VAL_STRUCT, VAL_ARRAY, VAL_REF, VAL_PILE };
+enum ValueType : uint8_t { VAL_VOID, VAL_INT, VAL_FLOAT, VAL_BOOL, VAL_STRUCT, VAL_ARRAY, VAL_REF, VAL_PILE };
+
+struct Aggregate;
 
+// 16-byte tagged value. Scalars and references live inline; structs, arrays
+// and piles live in a heap Aggregate shared between copies, so arithmetic never
+// touches the allocator and copying a container is O(1). Writers call
+// Unshare() first, which gives the Value its own copy if anyone else holds it.
 struct Value {
     ValueType type = VAL_VOID;
-    int intVal = 0;
-    float floatVal = 0.0f;
-    bool boolVal = false;
+    union {
+        int intVal;          // VAL_INT
+        float floatVal;      // VAL_FLOAT
+        bool boolVal;        // VAL_BOOL
+        Value* refVal;       // VAL_REF
+        Aggregate* object;   // VAL_STRUCT, VAL_ARRAY, VAL_PILE
+        uint64_t raw;
+    };
+
+    Value() : raw(0) {}
+    Value(int v) : type(VAL_INT), raw(0) { intVal = v; }
+    Value(float v) : type(VAL_FLOAT), raw(0) { floatVal = v; }
+    Value(bool v) : type(VAL_BOOL), raw(0) { boolVal = v; }
+    static Value Ref(Value* target);
+    static Value MakeAggregate(ValueType type);
+
+    Value(const Value& other);
+    Value(Value&& other) noexcept : type(other.type), raw(other.raw) { other.type = VAL_VOID; other.raw = 0; }
+    Value& operator=(const Value& other);
+    Value& operator=(Value&& other) noexcept;
+    ~Value() { if (IsAggregate()) Release(); }
+
+    bool IsAggregate() const { return type == VAL_STRUCT || type == VAL_ARRAY || type == VAL_PILE; }
+    Aggregate* Unshare(); // Aggregate only: copy-on-write before modifying `object`
+    int AsInt() const;
+    float AsFloat() const;
+    bool IsTruthy() const;
+
+private:
+    void Release();
+};
+
+static_assert(sizeof(Value) <= 16, "Value must stay a compact tagged union");
+
+// Aggregates belong to the script thread, so the count is not atomic
+struct Aggregate {
+    int refs = 1;          // Values sharing this aggregate
+    bool pinned = false;   // A reference into it was bound; copies must not share it
     std::string structName;
-    std::map<std::string, Value> members;
-    std::vector<Value> arrayElements;
-    std::vector<int> pileElements;
-    Value* refVal = nullptr;
-
-    Value() {}
-    Value(int v) : type(VAL_INT), intVal(v), floatVal((float)v) {}
-    Value(float v) : type(VAL_FLOAT), floatVal(v), intVal((int)v) {}
-    Value(bool v) : type(VAL_BOOL), boolVal(v), intVal(v), floatVal(v) {}
+    std::map<std::string, Value> members;  // VAL_STRUCT
+    std::vector<Value> arrayElements;      // VAL_ARRAY
+    std::vector<int> pileElements;         // VAL_PILE
+
+    Aggregate() = default;
+    // Copies the contents only: the copy starts unshared and unpinned. Nested
+    // aggregates are shared with the original until one side writes.
+    Aggregate(const Aggregate& other)
+        : structName(other.structName), members(other.members),
+          arrayElements(other.arrayElements), pileElements(other.pileElements) {}
+    Aggregate& operator=(const Aggregate&) = delete;
 };
 
+inline Value Value::Ref(Value* target) {
+    Value v;
+    v.type = VAL_REF;
+    v.refVal = target;
+    return v;
+}
+
+inline Value Value::MakeAggregate(ValueType type) {
+    Value v;
+    v.type = type;
+    v.object = new Aggregate();
+    return v;
+}
+
+inline Value::Value(const Value& other) : type(other.type), raw(other.raw) {
+    if (!IsAggregate()) return;
+    // A bound reference could write through to every sharer, so pinned
+    // aggregates are copied eagerly
+    if (object->pinned) object = new Aggregate(*other.object);
+    else object->refs++;
+}
+
+inline Value& Value::operator=(const Value& other) {
+    if (this != &other) {
+        Value copy(other);
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+inline Value& Value::operator=(Value&& other) noexcept {
+    if (this != &other) {
+        if (IsAggregate()) Release();
+        type = other.type;
+        raw = other.raw;
+        other.type = VAL_VOID;
+        other.raw = 0;
+    }
+    return *this;
+}
+
+inline void Value::Release() {
+    if (--object->refs == 0) delete object;
+    type = VAL_VOID;
+    raw = 0;
+}
+
+inline Aggregate* Value::Unshare() {
+    if (object->refs > 1) {
+        Aggregate* copy = new Aggregate(*object);
+        object->refs--;
+        object = copy;
+    }
+    return object;
+}
+
+inline int Value::AsInt() const {
+    switch (type) {
+        case VAL_INT: return intVal;
+        case VAL_FLOAT: return (int)floatVal;
+        case VAL_BOOL: return boolVal ? 1 : 0;
+        default: return 0;
+    }
+}
+
+inline float Value::AsFloat() const {
+    switch (type) {
+        case VAL_INT: return (float)intVal;
+        case VAL_FLOAT: return floatVal;
+        case VAL_BOOL: return boolVal ? 1.0f : 0.0f;
+        default: return 0.0f;
+    }
+}
+
+inline bool Value::IsTruthy() const {
+    return AsInt() != 0;
+}
+
 // --- Interpreter ---
 
+class Interpreter;
+
+// Builtins receive their arguments in place on the VM value stack
+typedef Value (*BuiltinFn)(Interpreter& interp, Value* args, int argc);
+// Reading for an echo pin, stamped like SetSensorValue(); false if none is wired
+typedef std::function<bool(int echoPin, float& distance, uint32_t& pinSequence)> SensorSource;
+// Level of a sensor's digital output pin; false if none is wired
+typedef std::function<bool(int pin, int& level)> DigitalSource;
+// A lidar scan, beam 0 first, stamped like SensorSource readings: fills up to
+// `capacity` distances and returns the beam count, 0 without a lidar
+typedef std::function<int(float* distances, int capacity, uint32_t& pinSequence)> ScanSource;
+
+struct BuiltinDef {
+    std::string name;
+    BuiltinFn fn;
+    bool firstArgByRef; // First argument is passed as a VAL_REF (push/pop)
+    StaticType result;  // Lets integer results such as millis() use integer operations
+};
+
+class Scheduler;
+class ProgramCache;
+
 class Interpreter {
 public:
     Interpreter();
     ~Interpreter(); // Destructor to stop thread
     
     void Load(const std::string& code);
-    void Start(); // Start execution thread
-    void Stop();  // Stop execution thread
+    // Hot reload: the running script switches to `code` when its current
+    // loop() call returns. setup() is not run again, the new global
+    // initializers are, and non-const globals whose name, type and shape are
+    // unchanged keep their values. Pins are untouched. Without a running
+    // script this is Load().
+    void Reload(const std::string& code);
+    void Start(); // Start execution on its own thread or the scheduler
+    void Stop();  // Stop execution and wait for it to finish
     bool IsRunning() const { return isRunning; }
     
     int GetPinValue(int pin);
+    // One consistent snapshot, no lock; returns its pin sequence for SetSensorValue()
+    uint32_t GetPinValues(int firstPin, int count, int* out);
     void SetPinValue(int pin, int value);
+    void SetPinValues(int firstPin, const int* values, int count); // Published as one update
+    // A reading simulated from the pin snapshot with sequence `pinSequence`.
+    // pulseIn() waits for a reading taken after the script's last motor
+    // command; without a sequence the reading is stamped with the current
+    // one, so it counts as fresh until the script's next motor command.
+    void SetSensorValue(int trigPin, int echoPin, float distance, uint32_t pinSequence);
     void SetSensorValue(int trigPin, int echoPin, float distance);
+    // Computes readings on demand instead: pulseIn() calls `source` on the
+    // script thread, and SetSensorValue() readings are ignored
+    void SetSensorSource(SensorSource source) { sensorSource = std::move(source); }
+    // digitalRead() asks `source` before falling back to the pin's value
+    void SetDigitalSource(DigitalSource source) { digitalSource = std::move(source); }
+    // lidar() reads its scans from `source`
+    void SetScanSource(ScanSource source) { scanSource = std::move(source); }
     void SetVariable(const std::string& name, float value);
     
+    // Time source for delay()/millis(); defaults to a private real-time clock.
+    // A clock serves one interpreter; don't share it between scripts.
+    void SetClock(SimClock* c) { clock = c ? c : &defaultClock; }
+    SimClock& GetClock() { return *clock; }
+    
+    // Runs the script on a shared worker pool instead of a thread of its own;
+    // takes effect on the next Start()
+    void SetScheduler(Scheduler* s) { scheduler = s; }
+    
+    // Lockstep mode: Start() creates no thread and the caller runs the script
+    // with RunLockstep(), between its own updates, on a SIMULATED clock it
+    // advances itself. Takes effect on the next Start().
+    void SetLockstep(bool enabled) { lockstep = enabled; }
+    // Runs the script until it sleeps past the clock's current time or the
+    // wall-clock deadline passes. Returns the simulated time the script next
+    // needs to run at: its wake time, NowMicros() if it is still computing,
+    // or INT64_MAX once it has stopped.
+    int64_t RunLockstep(std::chrono::steady_clock::time_point deadline);
+    
+    // Deepest script call chain; a deeper call stops the script with a runtime error
+    void SetMaxCallDepth(int depth) { maxCallDepth = depth; }
+    std::string GetRuntimeError(); // Why the script stopped on its own, empty otherwise
+    
+    // Shares parsed programs with other interpreters, so loading a script
+    // loaded before skips parsing and optimizing; null to always parse
+    void SetProgramCache(ProgramCache* cache) { programCache = cache; }
+    uint64_t FrontEndVariant() const; // The `variant` Load() finds and inserts programs under
+    
+    // Optimizer switches; take effect on the next Load()
+    void SetOptimize(bool enabled) { optimize = enabled; }
+    void SetProgramDump(std::ostream* out) { programDump = out; } // Prints the program before and after optimizing
+    
+    // Adds or replaces a builtin; takes effect on the next Load()
+    void RegisterBuiltin(const std::string& name, BuiltinFn fn, bool firstArgByRef = false, StaticType result = TYPE_UNKNOWN);
+    
     std::function<void()> updateCallback;
 
 private:
+    friend class Scheduler;
+
     std::string source;
     std::vector<Token> tokens;
     int currentToken;
+    Ast ast; // Parsed program, replaced by every Load()
     
     // Threading
     std::atomic<bool> isRunning;
-    std::thread executionThread;
-    std::mutex memoryMutex; // Protects globals, pins, sensors
+    std::thread executionThread;   // Without a scheduler
+    Scheduler* scheduler = nullptr;
+    ProgramCache* programCache = nullptr;
+    Scheduler* activeScheduler = nullptr; // Running the current Start()
+    bool lockstep = false;
+    bool lockstepActive = false;  // Started in lockstep mode and not yet finished
+    int64_t lockstepWake = 0;     // Simulated time a lockstep sleep ends
+    std::mutex memoryMutex; // Protects globals
+    SimClock defaultClock;
+    SimClock* clock = &defaultClock;
     
     // Globals
-    std::map<std::string, Value> globals;
+    std::vector<Value> globals;               // Indexed by VarDeclStmt::slot; sized once per Load()
+    std::map<std::string, int> globalIndices;
     std::map<std::string, FunctionDef> functions;
-    std::map<std::string, StructDef> structs;
-    std::map<std::string, EnumDef> enums;
+    std::vector<FunctionDef*> functionTable;  // Indexed by FunctionDef::index
+    std::map<std::string, StructDef, std::less<>> structs; // less<> allows lookup by token text
+    std::map<std::string, EnumDef, std::less<>> enums;
+    
+    PinBank pins; // Pins and sensors, lock-free
+    SensorSource sensorSource;
+    DigitalSource digitalSource;
+    ScanSource scanSource;
+    
+    std::vector<BuiltinDef> builtins;
+    std::map<std::string, int> builtinIndices;
+    void RegisterBuiltins();
     
-    std::map<int, int> pinValues;
-    std::map<int, float> sensorValues;
+    // Global declarations (and enum values), run before setup()
+    FunctionDef globalInit;
     
     struct StackFrame {
-        std::string functionName;
-        std::map<std::string, Value> locals;
-        bool returnHit = false;
-        Value returnValue;
+        const FunctionDef* function = nullptr;
+        std::vector<Value> locals; // localCount slots
+        int returnAddress = -1;
+        size_t stackBase = 0;
     };
     std::vector<StackFrame> callStack;
+    std::vector<std::vector<Value>> slotPool; // Recycled StackFrame::locals buffers
+    
+    // Bytecode
+    std::vector<Instr> code;
+    std::vector<int> codeLines;               // Source line of each instruction
+    std::vector<std::string> names;           // Identifiers and type names referenced by code
+    std::map<std::string, int> nameIndices;
+    std::vector<Value> valueStack;
     
     // Parsing
     void Tokenize();
-    Token Peek(int offset = 0);
-    Token Consume();
+    const Token& Peek(int offset = 0) const;
+    const Token& Consume();
     bool Match(TokenType type);
-    bool Check(TokenType type);
+    bool Check(TokenType type) const;
+    std::string_view Text(const Token& t) const;
     
     void ParseProgram();
-    void ParseGlobal();
-    StmtPtr ParseStatement();
-    StmtPtr ParseBlock();
-    ExprPtr ParseExpression();
-    ExprPtr ParseAssignment();
-    ExprPtr ParseLogicalOr();
-    ExprPtr ParseLogicalAnd();
-    ExprPtr ParseEquality();
-    ExprPtr ParseRelational();
-    ExprPtr ParseSum();
-    ExprPtr ParseProduct();
-    ExprPtr ParseUnary();
-    ExprPtr ParsePrimary();
+    void ParseGlobal(std::vector<StmtId>& globalDecls);
+    StmtId ParseStatement();
+    StmtId ParseBlock();
+    ExprId ParseExpression();
+    ExprId ParseAssignment();
+    ExprId ParseLogicalOr();
+    ExprId ParseLogicalAnd();
+    ExprId ParseEquality();
+    ExprId ParseRelational();
+    ExprId ParseSum();
+    ExprId ParseProduct();
+    ExprId ParseUnary();
+    ExprId ParsePrimary();
+    ExprId MakeBinary(ExprId left, TokenType op, ExprId right);
+    
+    // Name resolution and type inference
+    struct SlotType {
+        NameId type = 0;       // Declared type name
+        bool isArray = false;
+        bool known = false;    // False until declared, and again if redeclared with another type
+        bool conflict = false;
+    };
+    std::vector<SlotType> globalTypes;  // By global index
+    std::vector<SlotType> localTypes;   // By frame slot of the function being resolved
+    void Resolve();
+    void ResolveFunction(FunctionDef& func);
+    void DeclareLocals(StmtId id, std::map<NameId, int>& locals);
+    void DeclareType(std::vector<SlotType>& types, int slot, NameId type, bool isArray);
+    StaticType TypeOfName(std::string_view type) const;
+    bool DeclaredType(ExprId id, SlotType& out);
+    void ResolveStmt(StmtId id, const std::map<NameId, int>& locals);
+    void ResolveExpr(ExprId id, const std::map<NameId, int>& locals);
+    
+    // Optimization (rewrites the AST before Resolve)
+    struct InlineCandidate {
+        const FunctionDef* function = nullptr;
+        ExprId value = kNoNode;      // Returned expression for `return expr;` bodies, else kNoNode
+        std::set<NameId> locals;     // Parameters and declarations, renamed when inlined
+        std::set<NameId> freeNames;  // Globals it uses; must not be shadowed at the call site
+    };
+    bool optimize = true;
+    std::ostream* programDump = nullptr;
+    std::map<NameId, LiteralExpr> constGlobals;  // Propagated const globals and enum values
+    std::set<NameId> optimizingLocals;           // Locals of the function being simplified
+    const FunctionDef* optimizingFunction = nullptr;
+    void Optimize();
+    std::set<NameId> FunctionLocals(const FunctionDef& func);
+    bool ArgIsByRef(const CallExpr& call, uint32_t arg);
+    void CollectCallees(StmtId id, std::set<NameId>& callees);
+    bool MakeInlineCandidate(const FunctionDef& func, InlineCandidate& candidate);
+    void SimplifyFunction(FunctionDef& func);
+    void SimplifyStmt(StmtId id);
+    void FoldExpr(ExprId id);
+    void FoldAddress(ExprId id);
+    bool InlineStmt(StmtId id, const std::map<NameId, InlineCandidate>& candidates, const std::set<NameId>& callerLocals);
+    bool InlineExpr(ExprId id, const std::map<NameId, InlineCandidate>& candidates, const std::set<NameId>& callerLocals);
+    ExprId CastTo(ExprId id, StaticType to);
+    void DumpProgram(std::ostream& out, const char* title);
+    
+    // Compilation
+    void Compile();
+    void CompileFunction(FunctionDef& func, bool isGlobalInit);
+    void CompileStmt(StmtId id);
+    void CompileExpr(ExprId id);
+    void CompileConverted(ExprId id, StaticType to); // CompileExpr, then convert to a typed slot's type
+    void CompileAddress(ExprId id, AccessMode mode); // Pushes a VAL_REF for lvalues, a plain value otherwise
+    int Emit(OpCode op, int a = 0, int b = 0);
+    void PatchJump(int at);
+    int NameIndex(const std::string& name);
+    const FunctionDef* compilingFunction = nullptr;
+    bool compilingGlobals = false;
+    int compilingLine = 0;
     
     // Execution
-    void Execute(StmtPtr stmt);
-    Value Evaluate(ExprPtr expr);
-    Value* GetLValue(ExprPtr expr); // Get pointer to value for assignment
+    Value Invoke(const FunctionDef& func);
+    Value Run(int ip, size_t baseDepth);
+    void PushFrame(const FunctionDef& func, int returnAddress, size_t stackBase);
+    void PopFrame();
+    
+    // Runtime errors stop the script; the message is kept for GetRuntimeError()
+    static const int kDefaultMaxCallDepth = 100000; // Enough for a depth-first walk of a 300x300 maze
+    int maxCallDepth = kDefaultMaxCallDepth;
+    std::mutex errorMutex;
+    std::string runtimeError;
+    void RuntimeError(const std::string& message, int ip);
+    
+    // Scheduling: a script gives up its thread after every slice of loop
+    // iterations, and sleeps when it calls delay() or a slice looks like it
+    // is waiting on hardware. Run() then returns with its position saved in
+    // resumeIp, and the next Step() carries on from there.
+    static const int kSliceIterations = 4096;
+    enum RunPhase { PHASE_GLOBALS, PHASE_SETUP, PHASE_LOOP, PHASE_RELOAD_GLOBALS, PHASE_RELOAD_RESTORE };
+    enum StepResult { STEP_YIELD, STEP_SLEEP, STEP_DONE };
+    int sliceRemaining = kSliceIterations;
+    uint32_t sliceEffects = 0; // Stores and builtin calls in the current slice
+    bool slicePolled = false;  // The current slice read the clock or a sensor
+    RunPhase phase = PHASE_GLOBALS;
+    const FunctionDef* setupFunction = nullptr;
+    const FunctionDef* loopFunction = nullptr;
+    int resumeIp = -1;         // Where Run() stopped, -1 between calls
+    bool yieldRequested = false;
+    int64_t sleepMicros = 0;   // Requested sleep, 0 for a plain yield
+    void (*wakeAction)(Interpreter&) = nullptr; // Rest of a builtin that slept; may sleep again
+    void EndSlice();
+    void RequestSleep(int64_t micros, void (*then)(Interpreter&) = nullptr); // For builtins
+    StepResult Step();  // Runs until the script sleeps, yields or ends
+    void FinishRun();   // Completes a pending wake action and detaches from the clock
+    
+    // Hot reload, handed from Reload() to the script thread
+    std::mutex reloadMutex;
+    std::string reloadSource;
+    std::atomic<bool> reloadPending{false};
+    struct KeptGlobal {
+        std::string name;
+        std::string type;
+        bool isArray;
+        Value value;
+    };
+    std::vector<KeptGlobal> keptGlobals; // Old values, restored after the new initializers ran
+    void BuildProgram(const std::string& code); // Load() without stopping or clearing pins
+    void ApplyReload();   // At a loop() boundary
+    void RestoreGlobals();
+    
+    // pulseIn(): polls until the echo pin has a reading newer than the last
+    // motor command, or the timeout passes
+    uint32_t motorCommand = 0; // Pin sequence of the last write to pins 8-11
+    int pulseEcho = -1;
+    int64_t pulseDeadline = 0;
+    void PollEcho(Value& result);
+    // lidar(): the same wait, for a scan into the array `scanArray` refers to
+    Value* scanArray = nullptr;
+    std::vector<float> scanBuffer;
+    void PollScan(Value& result);
     
     Value CreateDefaultValue(const std::string& type);
-    Value CallFunction(const std::string& name, const std::vector<Value>& args);
     
-    void RunLoop(); // The thread loop
+    void RunLoop(); // The thread loop without a scheduler
 };
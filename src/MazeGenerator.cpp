@@ -20,6 +20,10 @@ int MazeGenerator::GetIndex(int x, int y) {
 }
 
 void MazeGenerator::Generate(int w, int h) {
+    Generate(w, h, (unsigned)time(NULL));
+}
+
+void MazeGenerator::Generate(int w, int h, unsigned seed) {
     width = w;
     height = h;
     grid.clear();
@@ -45,7 +49,7 @@ void MazeGenerator::Generate(int w, int h) {
     grid[startIdx].visited = true;
     stack.push(startIdx);
     
-    srand(time(NULL));
+    srand(seed);
     
     while (!stack.empty()) {
         int current = stack.top();
@@ -69,11 +73,34 @@ void MazeGenerator::Generate(int w, int h) {
     }
     
     // Create Exit (Top Center)
-    int exitX = width / 2;
-    int exitIdx = GetIndex(exitX, 0);
+    int exitIdx = GetIndex(ExitX(), ExitY());
     if (exitIdx != -1) {
         grid[exitIdx].wallNorth = false;
     }
+    
+    walls.Build(*this);
+}
+
+void MazeGenerator::SetWall(int x, int y, uint8_t side, bool present) {
+    int index = GetIndex(x, y);
+    if (index == -1) return;
+    Cell& cell = grid[index];
+    int neighbor = -1;
+    switch (side) {
+        case WallGrid::WALL_NORTH: cell.wallNorth = present; neighbor = GetIndex(x, y - 1); break;
+        case WallGrid::WALL_SOUTH: cell.wallSouth = present; neighbor = GetIndex(x, y + 1); break;
+        case WallGrid::WALL_EAST: cell.wallEast = present; neighbor = GetIndex(x + 1, y); break;
+        case WallGrid::WALL_WEST: cell.wallWest = present; neighbor = GetIndex(x - 1, y); break;
+        default: return;
+    }
+    if (neighbor != -1) {
+        Cell& other = grid[neighbor];
+        if (side == WallGrid::WALL_NORTH) other.wallSouth = present;
+        else if (side == WallGrid::WALL_SOUTH) other.wallNorth = present;
+        else if (side == WallGrid::WALL_EAST) other.wallWest = present;
+        else other.wallEast = present;
+    }
+    walls.SetWall(x, y, side, present); // Rescans one row or column, not the maze
 }
 
 std::vector<int> MazeGenerator::GetUnvisitedNeighbors(int index) {
@@ -119,42 +146,6 @@ void MazeGenerator::RemoveWalls(int current, int next) {
     }
 }
 
-void MazeGenerator::Draw() {
-    float cellSize = 20.0f;
-    float offsetX = 400.0f; // Offset for UI
-    float offsetY = 50.0f;
-    
-    // Auto-scale
-    float availWidth = GetScreenWidth() - offsetX - 50;
-    float availHeight = GetScreenHeight() - 100;
-    float scaleX = availWidth / (width * cellSize);
-    float scaleY = availHeight / (height * cellSize);
-    float scale = (scaleX < scaleY) ? scaleX : scaleY;
-    if (scale < 1.0f) cellSize *= scale;
-
-    // Cache for Simulation
-    renderCellSize = cellSize;
-    renderOffsetX = offsetX;
-    renderOffsetY = offsetY;
-
-    for (const auto& cell : grid) {
-        float x = offsetX + cell.x * cellSize;
-        float y = offsetY + cell.y * cellSize;
-        
-        if (cell.wallNorth) DrawLineEx({x, y}, {x + cellSize, y}, 2.0f, BLACK);
-        if (cell.wallSouth) DrawLineEx({x, y + cellSize}, {x + cellSize, y + cellSize}, 2.0f, BLACK);
-        if (cell.wallEast) DrawLineEx({x + cellSize, y}, {x + cellSize, y + cellSize}, 2.0f, BLACK);
-        if (cell.wallWest) DrawLineEx({x, y}, {x, y + cellSize}, 2.0f, BLACK);
-    }
-}
-
-Vector2 MazeGenerator::GetScreenPos(float gridX, float gridY) const {
-    return {
-        renderOffsetX + gridX * renderCellSize,
-        renderOffsetY + gridY * renderCellSize
-    };
-}
-
 const Cell* MazeGenerator::GetCell(int x, int y) const {
     if (x < 0 || x >= width || y < 0 || y >= height) return nullptr;
     return &grid[y * width + x];
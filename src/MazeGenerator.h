@@ -1,5 +1,6 @@
 #pragma once
-#include "raylib.h"
+#include "Vec2.h"
+#include "WallGrid.h"
 #include <vector>
 
 struct Cell {
@@ -17,26 +18,36 @@ public:
     int height;
     int innerWidth;
     int innerHeight;
-    
-    std::vector<Cell> grid;
 
     MazeGenerator();
     
-    void Generate(int w, int h);
-    void Draw();
+    void Generate(int w, int h);                // Seeded from the time
+    void Generate(int w, int h, unsigned seed); // The same seed gives the same maze
     
-    // Coordinate Conversion
-    Vector2 GetScreenPos(float gridX, float gridY) const;
+    // Rendering (MazeGeneratorDraw.cpp, raylib builds only)
+    void Draw();
+    Vec2 GetScreenPos(float gridX, float gridY) const;
     float GetRenderCellSize() const { return renderCellSize; }
     
     // Data Access
     const Cell* GetCell(int x, int y) const;
+    const std::vector<Cell>& Cells() const { return grid; } // Row-major; change walls with SetWall()
+    const WallGrid& Walls() const { return walls; } // For ray casting; kept in step with the grid
+    // Adds or removes a wall (a WallGrid::WALL_* side of cell x, y) on both
+    // cells it separates. Not while a simulation runs on this maze.
+    void SetWall(int x, int y, uint8_t side, bool present);
+    // Exit cell: top row, open to the north (the entrance is bottom centre)
+    int ExitX() const { return width / 2; }
+    int ExitY() const { return 0; }
 
 private:
     int GetIndex(int x, int y);
     std::vector<int> GetUnvisitedNeighbors(int index);
     void RemoveWalls(int current, int next);
     
+    std::vector<Cell> grid;
+    WallGrid walls;
+    
     // Render State (Cached in Draw)
     float renderCellSize;
     float renderOffsetX;
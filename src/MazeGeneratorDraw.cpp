@@ -0,0 +1,38 @@
+#include "MazeGenerator.h"
+#include "raylib.h"
+
+void MazeGenerator::Draw() {
+    float cellSize = 20.0f;
+    float offsetX = 400.0f; // Offset for UI
+    float offsetY = 50.0f;
+    
+    // Auto-scale
+    float availWidth = GetScreenWidth() - offsetX - 50;
+    float availHeight = GetScreenHeight() - 100;
+    float scaleX = availWidth / (width * cellSize);
+    float scaleY = availHeight / (height * cellSize);
+    float scale = (scaleX < scaleY) ? scaleX : scaleY;
+    if (scale < 1.0f) cellSize *= scale;
+
+    // Cache for Simulation
+    renderCellSize = cellSize;
+    renderOffsetX = offsetX;
+    renderOffsetY = offsetY;
+
+    for (const auto& cell : Cells()) {
+        float x = offsetX + cell.x * cellSize;
+        float y = offsetY + cell.y * cellSize;
+        
+        if (cell.wallNorth) DrawLineEx({x, y}, {x + cellSize, y}, 2.0f, BLACK);
+        if (cell.wallSouth) DrawLineEx({x, y + cellSize}, {x + cellSize, y + cellSize}, 2.0f, BLACK);
+        if (cell.wallEast) DrawLineEx({x + cellSize, y}, {x + cellSize, y + cellSize}, 2.0f, BLACK);
+        if (cell.wallWest) DrawLineEx({x, y}, {x, y + cellSize}, 2.0f, BLACK);
+    }
+}
+
+Vec2 MazeGenerator::GetScreenPos(float gridX, float gridY) const {
+    return {
+        renderOffsetX + gridX * renderCellSize,
+        renderOffsetY + gridY * renderCellSize
+    };
+}
@@ -0,0 +1,1009 @@
+#include "Interpreter.h"
+#include <cmath>
+#include <ostream>
+
+// --- Optimizer ---
+// Rewrites the AST between ParseProgram() and Resolve():
+//  - const globals and enum values are replaced by their literal value
+//  - constant expressions are folded with the VM's own arithmetic: int
+//    when both literals are integral, float otherwise, as the resolver types them
+//  - branches and loops with a constant condition are pruned
+//  - small functions that call no other script function (and so cannot
+//    recurse) are inlined into their callers
+// Nodes are rewritten in place, so a parent's child id stays valid whatever
+// the child turns into.
+
+static const int kInlineMaxNodes = 40; // Largest function body worth inlining
+static const int kInlineRounds = 4;    // Bounds how deep wrappers of wrappers get flattened
+
+// Literal values, converted the way Value converts them at run time
+
+static bool LiteralIntegral(const LiteralExpr& l) {
+    return l.isBool || l.isInt;
+}
+
+static float LiteralFloat(const LiteralExpr& l) {
+    return l.isBool ? (l.boolVal ? 1.0f : 0.0f) : l.isInt ? (float)l.intVal : l.numberVal;
+}
+
+static bool LiteralFitsInt(const LiteralExpr& l) {
+    float f = LiteralFloat(l);
+    return LiteralIntegral(l) || (f > -2147483648.0f && f < 2147483648.0f);
+}
+
+static int LiteralInt(const LiteralExpr& l) {
+    return l.isBool ? (l.boolVal ? 1 : 0) : l.isInt ? l.intVal : (int)l.numberVal;
+}
+
+static Expr NumberLiteral(float v) {
+    Expr e(EXPR_LITERAL);
+    e.literal.numberVal = v;
+    return e;
+}
+
+static Expr IntLiteral(int v) {
+    Expr e(EXPR_LITERAL);
+    e.literal.numberVal = (float)v;
+    e.literal.intVal = v;
+    e.literal.isInt = true;
+    return e;
+}
+
+// 32-bit wrapping arithmetic, as OP_ADD_I and friends compute it
+static int WrapInt(int64_t v) {
+    return (int)(uint32_t)v;
+}
+
+static Expr BoolLiteral(bool v) {
+    Expr e(EXPR_LITERAL);
+    e.literal.isBool = true;
+    e.literal.boolVal = v;
+    return e;
+}
+
+// True if `id` is a literal whose truthiness is known at compile time
+static bool ConstantCondition(const Ast& ast, ExprId id, bool& truthy) {
+    if (id == kNoNode) return false;
+    const Expr& e = ast.exprs[id];
+    if (e.kind != EXPR_LITERAL || !LiteralFitsInt(e.literal)) return false;
+    truthy = LiteralInt(e.literal) != 0;
+    return true;
+}
+
+// `l` converted to a typed slot or cast target; false if the VM's
+// conversion is not defined for it at compile time
+static bool CastLiteral(const LiteralExpr& l, StaticType to, Expr& out) {
+    switch (to) {
+        case TYPE_INT:
+            if (!LiteralFitsInt(l)) return false;
+            out = IntLiteral(LiteralInt(l));
+            return true;
+        case TYPE_FLOAT:
+            out = NumberLiteral(LiteralFloat(l));
+            return true;
+        case TYPE_BOOL:
+            if (!LiteralFitsInt(l)) return false;
+            out = BoolLiteral(LiteralInt(l) != 0);
+            return true;
+        default:
+            out = Expr(EXPR_LITERAL);
+            out.literal = l;
+            return true;
+    }
+}
+
+static StaticType CastType(TokenType op) {
+    switch (op) {
+        case TOKEN_INT: return TYPE_INT;
+        case TOKEN_FLOAT: return TYPE_FLOAT;
+        case TOKEN_BOOL: return TYPE_BOOL;
+        default: return TYPE_UNKNOWN;
+    }
+}
+
+static bool IsCast(TokenType op) {
+    return CastType(op) != TYPE_UNKNOWN;
+}
+
+// --- Read-only walkers ---
+
+// Calls fn(id) on every expression under `id`, parents first
+template <typename Fn>
+static void VisitExpr(const Ast& ast, ExprId id, Fn& fn) {
+    if (id == kNoNode) return;
+    fn(id);
+    const Expr& e = ast.exprs[id];
+    switch (e.kind) {
+        case EXPR_BINARY: VisitExpr(ast, e.binary.left, fn); VisitExpr(ast, e.binary.right, fn); break;
+        case EXPR_UNARY: VisitExpr(ast, e.unary.right, fn); break;
+        case EXPR_POSTFIX: VisitExpr(ast, e.postfix.left, fn); break;
+        case EXPR_CALL:
+            for (uint32_t i = 0; i < e.call.argCount; i++) VisitExpr(ast, ast.children[e.call.firstArg + i], fn);
+            break;
+        case EXPR_MEMBER: VisitExpr(ast, e.member.object, fn); break;
+        case EXPR_INDEX: VisitExpr(ast, e.index.array, fn); VisitExpr(ast, e.index.index, fn); break;
+        case EXPR_ASSIGN: VisitExpr(ast, e.assign.target, fn); VisitExpr(ast, e.assign.value, fn); break;
+        default: break;
+    }
+}
+
+// Calls stmtFn(id) on every statement and exprFn(id) on every expression under `id`
+template <typename StmtFn, typename ExprFn>
+static void VisitStmt(const Ast& ast, StmtId id, StmtFn& stmtFn, ExprFn& exprFn) {
+    if (id == kNoNode) return;
+    stmtFn(id);
+    const Stmt& s = ast.stmts[id];
+    switch (s.kind) {
+        case STMT_BLOCK:
+            for (uint32_t i = 0; i < s.block.count; i++) VisitStmt(ast, ast.children[s.block.first + i], stmtFn, exprFn);
+            break;
+        case STMT_IF:
+            VisitExpr(ast, s.ifStmt.condition, exprFn);
+            VisitStmt(ast, s.ifStmt.thenBranch, stmtFn, exprFn);
+            VisitStmt(ast, s.ifStmt.elseBranch, stmtFn, exprFn);
+            break;
+        case STMT_WHILE:
+        case STMT_DO_WHILE:
+            VisitExpr(ast, s.loop.condition, exprFn);
+            VisitStmt(ast, s.loop.body, stmtFn, exprFn);
+            break;
+        case STMT_FOR:
+            VisitStmt(ast, s.forStmt.init, stmtFn, exprFn);
+            VisitExpr(ast, s.forStmt.condition, exprFn);
+            VisitExpr(ast, s.forStmt.increment, exprFn);
+            VisitStmt(ast, s.forStmt.body, stmtFn, exprFn);
+            break;
+        case STMT_RETURN: VisitExpr(ast, s.ret.value, exprFn); break;
+        case STMT_EXPR: VisitExpr(ast, s.expr.expression, exprFn); break;
+        case STMT_VAR_DECL:
+            VisitExpr(ast, s.decl.initializer, exprFn);
+            VisitExpr(ast, s.decl.arraySize, exprFn);
+            break;
+    }
+}
+
+static int NodeCount(const Ast& ast, StmtId id) {
+    int count = 0;
+    auto countStmt = [&](StmtId) { count++; };
+    auto countExpr = [&](ExprId) { count++; };
+    VisitStmt(ast, id, countStmt, countExpr);
+    return count;
+}
+
+// Dropping a declaration would change what its name resolves to elsewhere in
+// the function (locals are function-scoped), so pruning keeps those
+static bool HasDecl(const Ast& ast, StmtId id) {
+    bool found = false;
+    auto onStmt = [&](StmtId s) { if (ast.stmts[s].kind == STMT_VAR_DECL) found = true; };
+    auto onExpr = [](ExprId) {};
+    VisitStmt(ast, id, onStmt, onExpr);
+    return found;
+}
+
+static bool HasReturn(const Ast& ast, StmtId id) {
+    bool found = false;
+    auto onStmt = [&](StmtId s) { if (ast.stmts[s].kind == STMT_RETURN) found = true; };
+    auto onExpr = [](ExprId) {};
+    VisitStmt(ast, id, onStmt, onExpr);
+    return found;
+}
+
+// The variable an lvalue path (a.b[i].c) is rooted at, or kNoNode
+static ExprId LvalueRoot(const Ast& ast, ExprId id) {
+    while (id != kNoNode) {
+        const Expr& e = ast.exprs[id];
+        if (e.kind == EXPR_VARIABLE) return id;
+        if (e.kind == EXPR_MEMBER) id = e.member.object;
+        else if (e.kind == EXPR_INDEX) id = e.index.array;
+        else return kNoNode;
+    }
+    return kNoNode;
+}
+
+// --- Cloning (for inlining) ---
+
+// Copies an expression. Names in `renamed` get `prefix` prepended; variables
+// in `substitutions` are replaced by a copy of the mapped expression.
+static ExprId CloneExpr(Ast& ast, ExprId id, const std::string& prefix, const std::set<NameId>& renamed,
+                        const std::map<NameId, ExprId>& substitutions) {
+    if (id == kNoNode) return kNoNode;
+    Expr e = ast.exprs[id];
+    switch (e.kind) {
+        case EXPR_VARIABLE: {
+            auto sub = substitutions.find(e.variable.name);
+            if (sub != substitutions.end()) return CloneExpr(ast, sub->second, "", {}, {});
+            if (renamed.count(e.variable.name)) e.variable.name = ast.Intern(prefix + ast.Name(e.variable.name));
+            break;
+        }
+        case EXPR_BINARY:
+            e.binary.left = CloneExpr(ast, e.binary.left, prefix, renamed, substitutions);
+            e.binary.right = CloneExpr(ast, e.binary.right, prefix, renamed, substitutions);
+            break;
+        case EXPR_UNARY:
+            e.unary.right = CloneExpr(ast, e.unary.right, prefix, renamed, substitutions);
+            break;
+        case EXPR_POSTFIX:
+            e.postfix.left = CloneExpr(ast, e.postfix.left, prefix, renamed, substitutions);
+            break;
+        case EXPR_CALL: {
+            std::vector<ExprId> args;
+            for (uint32_t i = 0; i < e.call.argCount; i++) {
+                args.push_back(CloneExpr(ast, ast.children[e.call.firstArg + i], prefix, renamed, substitutions));
+            }
+            e.call.firstArg = ast.AddChildren(args);
+            break;
+        }
+        case EXPR_MEMBER:
+            e.member.object = CloneExpr(ast, e.member.object, prefix, renamed, substitutions);
+            break;
+        case EXPR_INDEX:
+            e.index.array = CloneExpr(ast, e.index.array, prefix, renamed, substitutions);
+            e.index.index = CloneExpr(ast, e.index.index, prefix, renamed, substitutions);
+            break;
+        case EXPR_ASSIGN:
+            e.assign.target = CloneExpr(ast, e.assign.target, prefix, renamed, substitutions);
+            e.assign.value = CloneExpr(ast, e.assign.value, prefix, renamed, substitutions);
+            break;
+        case EXPR_LITERAL:
+            break;
+    }
+    return ast.Add(e);
+}
+
+static StmtId CloneStmt(Ast& ast, StmtId id, const std::string& prefix, const std::set<NameId>& renamed) {
+    if (id == kNoNode) return kNoNode;
+    static const std::map<NameId, ExprId> none;
+    Stmt s = ast.stmts[id];
+    switch (s.kind) {
+        case STMT_BLOCK: {
+            std::vector<StmtId> stmts;
+            for (uint32_t i = 0; i < s.block.count; i++) {
+                stmts.push_back(CloneStmt(ast, ast.children[s.block.first + i], prefix, renamed));
+            }
+            s.block.first = ast.AddChildren(stmts);
+            break;
+        }
+        case STMT_IF:
+            s.ifStmt.condition = CloneExpr(ast, s.ifStmt.condition, prefix, renamed, none);
+            s.ifStmt.thenBranch = CloneStmt(ast, s.ifStmt.thenBranch, prefix, renamed);
+            s.ifStmt.elseBranch = CloneStmt(ast, s.ifStmt.elseBranch, prefix, renamed);
+            break;
+        case STMT_WHILE:
+        case STMT_DO_WHILE:
+            s.loop.condition = CloneExpr(ast, s.loop.condition, prefix, renamed, none);
+            s.loop.body = CloneStmt(ast, s.loop.body, prefix, renamed);
+            break;
+        case STMT_FOR:
+            s.forStmt.init = CloneStmt(ast, s.forStmt.init, prefix, renamed);
+            s.forStmt.condition = CloneExpr(ast, s.forStmt.condition, prefix, renamed, none);
+            s.forStmt.increment = CloneExpr(ast, s.forStmt.increment, prefix, renamed, none);
+            s.forStmt.body = CloneStmt(ast, s.forStmt.body, prefix, renamed);
+            break;
+        case STMT_RETURN:
+            s.ret.value = CloneExpr(ast, s.ret.value, prefix, renamed, none);
+            break;
+        case STMT_EXPR:
+            s.expr.expression = CloneExpr(ast, s.expr.expression, prefix, renamed, none);
+            break;
+        case STMT_VAR_DECL:
+            if (renamed.count(s.decl.name)) s.decl.name = ast.Intern(prefix + ast.Name(s.decl.name));
+            s.decl.initializer = CloneExpr(ast, s.decl.initializer, prefix, renamed, none);
+            s.decl.arraySize = CloneExpr(ast, s.decl.arraySize, prefix, renamed, none);
+            break;
+    }
+    return ast.Add(s);
+}
+
+// --- Pipeline ---
+
+void Interpreter::Optimize() {
+    constGlobals.clear();
+    const BlockStmt globalBlock = ast.stmts[globalInit.body].block;
+
+    // A const global is propagated only if it is declared once and never
+    // used where its storage is needed (assigned, ++, &, passed by reference)
+    std::map<NameId, int> declCount;
+    for (uint32_t i = 0; i < globalBlock.count; i++) {
+        declCount[ast.stmts[ast.children[globalBlock.first + i]].decl.name]++;
+    }
+    std::set<NameId> addressed;
+    auto scan = [&](const FunctionDef& func, const std::set<NameId>& locals) {
+        bool refReturn = !func.returnType.empty() && func.returnType.back() == '&';
+        auto mark = [&](ExprId target) {
+            ExprId root = LvalueRoot(ast, target);
+            if (root != kNoNode && !locals.count(ast.exprs[root].variable.name)) {
+                addressed.insert(ast.exprs[root].variable.name);
+            }
+        };
+        auto onStmt = [&](StmtId id) {
+            const Stmt& s = ast.stmts[id];
+            if (s.kind == STMT_VAR_DECL && s.decl.initializer) {
+                const std::string& type = ast.Name(s.decl.type);
+                if (!type.empty() && type.back() == '&') mark(s.decl.initializer);
+            } else if (s.kind == STMT_RETURN && refReturn) {
+                mark(s.ret.value);
+            }
+        };
+        auto onExpr = [&](ExprId id) {
+            const Expr& e = ast.exprs[id];
+            if (e.kind == EXPR_ASSIGN) mark(e.assign.target);
+            else if (e.kind == EXPR_POSTFIX) mark(e.postfix.left);
+            else if (e.kind == EXPR_UNARY && (e.unary.op == TOKEN_INC || e.unary.op == TOKEN_DEC || e.unary.op == TOKEN_AMPERSAND)) mark(e.unary.right);
+            else if (e.kind == EXPR_CALL) {
+                for (uint32_t i = 0; i < e.call.argCount; i++) {
+                    if (ArgIsByRef(e.call, i)) mark(ast.children[e.call.firstArg + i]);
+                }
+            }
+        };
+        VisitStmt(ast, func.body, onStmt, onExpr);
+    };
+    scan(globalInit, {});
+    for (auto& entry : functions) scan(entry.second, FunctionLocals(entry.second));
+
+    // Globals in declaration order: a const only propagates into later declarations
+    optimizingFunction = &globalInit;
+    optimizingLocals.clear();
+    for (uint32_t i = 0; i < globalBlock.count; i++) {
+        StmtId id = ast.children[globalBlock.first + i];
+        SimplifyStmt(id);
+        const VarDeclStmt& decl = ast.stmts[id].decl;
+        if (!decl.isConst || decl.isArray || !decl.initializer) continue;
+        if (declCount[decl.name] != 1 || addressed.count(decl.name)) continue;
+        const Expr& init = ast.exprs[decl.initializer];
+        // Propagate the value the declaration stores, e.g. 2.0f for `const float k = 2;`
+        Expr stored(EXPR_LITERAL);
+        if (init.kind == EXPR_LITERAL && CastLiteral(init.literal, TypeOfName(ast.Name(decl.type)), stored)) {
+            constGlobals[decl.name] = stored.literal;
+        }
+    }
+
+    for (auto& entry : functions) SimplifyFunction(entry.second);
+
+    // Inline bottom-up: a function that calls no script function is a
+    // candidate, and inlining it can turn its callers into candidates too.
+    // After the first round only callers of new candidates are revisited.
+    std::map<NameId, std::set<NameId>> callees; // Script functions each function calls
+    std::set<NameId> changed;
+    for (auto& entry : functions) {
+        NameId name = ast.Intern(entry.first);
+        CollectCallees(entry.second.body, callees[name]);
+        changed.insert(name);
+    }
+    std::map<NameId, InlineCandidate> candidates;
+    for (int round = 0; round < kInlineRounds && !changed.empty(); round++) {
+        std::set<NameId> fresh;
+        for (NameId name : changed) {
+            candidates.erase(name);
+            InlineCandidate candidate;
+            if (callees[name].empty() && MakeInlineCandidate(functions.find(ast.Name(name))->second, candidate)) {
+                candidates[name] = candidate;
+                fresh.insert(name);
+            }
+        }
+        changed.clear();
+        for (auto& entry : functions) {
+            NameId name = ast.Intern(entry.first);
+            std::set<NameId>& calls = callees[name];
+            bool callsFresh = false;
+            for (NameId callee : calls) callsFresh |= fresh.count(callee) != 0;
+            if (!callsFresh || !InlineStmt(entry.second.body, candidates, FunctionLocals(entry.second))) continue;
+            SimplifyFunction(entry.second);
+            calls.clear();
+            CollectCallees(entry.second.body, calls);
+            changed.insert(name);
+        }
+    }
+    optimizingFunction = nullptr;
+}
+
+std::set<NameId> Interpreter::FunctionLocals(const FunctionDef& func) {
+    std::set<NameId> locals;
+    if (&func == &globalInit) return locals;
+    for (auto& param : func.parameters) locals.insert(ast.Intern(param.second));
+    auto onStmt = [&](StmtId id) {
+        if (ast.stmts[id].kind == STMT_VAR_DECL) locals.insert(ast.stmts[id].decl.name);
+    };
+    auto onExpr = [](ExprId) {};
+    VisitStmt(ast, func.body, onStmt, onExpr);
+    return locals;
+}
+
+bool Interpreter::ArgIsByRef(const CallExpr& call, uint32_t arg) {
+    const std::string& callee = ast.Name(call.callee);
+    auto func = functions.find(callee);
+    if (func != functions.end()) {
+        auto& params = func->second.parameters;
+        return arg < params.size() && !params[arg].first.empty() && params[arg].first.back() == '&';
+    }
+    auto builtin = builtinIndices.find(callee);
+    return arg == 0 && arg < call.argCount && builtin != builtinIndices.end() && builtins[builtin->second].firstArgByRef;
+}
+
+void Interpreter::CollectCallees(StmtId id, std::set<NameId>& callees) {
+    auto onStmt = [](StmtId) {};
+    auto onExpr = [&](ExprId e) {
+        const Expr& expr = ast.exprs[e];
+        if (expr.kind == EXPR_CALL && functions.count(ast.Name(expr.call.callee))) callees.insert(expr.call.callee);
+    };
+    VisitStmt(ast, id, onStmt, onExpr);
+}
+
+// Callers must already know func calls no script function
+bool Interpreter::MakeInlineCandidate(const FunctionDef& func, InlineCandidate& candidate) {
+    for (auto& param : func.parameters) {
+        if (!param.first.empty() && param.first.back() == '&') return false;
+    }
+    if (!func.returnType.empty() && func.returnType.back() == '&') return false;
+    if (NodeCount(ast, func.body) > kInlineMaxNodes) return false;
+
+    candidate.function = &func;
+    if (HasReturn(ast, func.body)) {
+        // Only `return expr;` bodies inline into expressions, and only
+        // if evaluating expr cannot change any script variable
+        const BlockStmt& body = ast.stmts[func.body].block;
+        if (body.count != 1) return false;
+        const Stmt& ret = ast.stmts[ast.children[body.first]];
+        if (ret.kind != STMT_RETURN || !ret.ret.value) return false;
+        bool pure = true;
+        auto onExpr = [&](ExprId id) {
+            const Expr& e = ast.exprs[id];
+            if (e.kind == EXPR_ASSIGN || e.kind == EXPR_POSTFIX || (e.kind == EXPR_UNARY && e.unary.op != TOKEN_NOT && e.unary.op != TOKEN_MINUS && !IsCast(e.unary.op))) pure = false;
+            if (e.kind == EXPR_CALL && ArgIsByRef(e.call, 0)) pure = false;
+        };
+        VisitExpr(ast, ret.ret.value, onExpr);
+        if (!pure) return false;
+        candidate.value = ret.ret.value;
+    }
+    candidate.locals = FunctionLocals(func);
+    auto onStmt = [](StmtId) {};
+    auto onExpr = [&](ExprId id) {
+        const Expr& e = ast.exprs[id];
+        if (e.kind == EXPR_VARIABLE && !candidate.locals.count(e.variable.name)) candidate.freeNames.insert(e.variable.name);
+    };
+    VisitStmt(ast, func.body, onStmt, onExpr);
+    return true;
+}
+
+void Interpreter::SimplifyFunction(FunctionDef& func) {
+    optimizingFunction = &func;
+    optimizingLocals = FunctionLocals(func);
+    SimplifyStmt(func.body);
+}
+
+// --- Folding and pruning ---
+
+void Interpreter::SimplifyStmt(StmtId id) {
+    if (id == kNoNode) return;
+    const Stmt s = ast.stmts[id]; // Copy: the node itself may be replaced below
+    bool truthy;
+    switch (s.kind) {
+        case STMT_BLOCK: {
+            std::vector<StmtId> kept;
+            bool unreachable = false;
+            for (uint32_t i = 0; i < s.block.count; i++) {
+                StmtId child = ast.children[s.block.first + i];
+                if (unreachable) {
+                    if (HasDecl(ast, child)) kept.push_back(child);
+                    continue;
+                }
+                SimplifyStmt(child);
+                const Stmt& c = ast.stmts[child];
+                if (c.kind == STMT_BLOCK && c.block.count == 0) continue;
+                kept.push_back(child);
+                if (c.kind == STMT_RETURN) unreachable = true;
+            }
+            // Survivors keep their order, so they fit in the block's own run
+            for (size_t i = 0; i < kept.size(); i++) ast.children[s.block.first + i] = kept[i];
+            ast.stmts[id].block.count = (uint32_t)kept.size();
+            break;
+        }
+        case STMT_IF:
+            FoldExpr(s.ifStmt.condition);
+            SimplifyStmt(s.ifStmt.thenBranch);
+            SimplifyStmt(s.ifStmt.elseBranch);
+            if (ConstantCondition(ast, s.ifStmt.condition, truthy)) {
+                StmtId taken = truthy ? s.ifStmt.thenBranch : s.ifStmt.elseBranch;
+                StmtId dropped = truthy ? s.ifStmt.elseBranch : s.ifStmt.thenBranch;
+                if (HasDecl(ast, dropped)) break;
+                ast.stmts[id] = taken ? ast.stmts[taken] : Stmt(STMT_BLOCK);
+            }
+            break;
+        case STMT_WHILE:
+            FoldExpr(s.loop.condition);
+            SimplifyStmt(s.loop.body);
+            if (ConstantCondition(ast, s.loop.condition, truthy)) {
+                if (truthy) {
+                    // while (true): a for loop without a condition skips the test
+                    Stmt loop(STMT_FOR);
+                    loop.line = s.line;
+                    loop.forStmt.body = s.loop.body;
+                    ast.stmts[id] = loop;
+                } else if (!HasDecl(ast, s.loop.body)) {
+                    ast.stmts[id] = Stmt(STMT_BLOCK);
+                }
+            }
+            break;
+        case STMT_DO_WHILE:
+            SimplifyStmt(s.loop.body);
+            FoldExpr(s.loop.condition);
+            if (ConstantCondition(ast, s.loop.condition, truthy) && !truthy) {
+                ast.stmts[id] = ast.stmts[s.loop.body];
+            }
+            break;
+        case STMT_FOR:
+            SimplifyStmt(s.forStmt.init);
+            FoldExpr(s.forStmt.condition);
+            FoldExpr(s.forStmt.increment);
+            SimplifyStmt(s.forStmt.body);
+            if (ConstantCondition(ast, s.forStmt.condition, truthy)) {
+                if (truthy) {
+                    ast.stmts[id].forStmt.condition = kNoNode;
+                } else if (!HasDecl(ast, s.forStmt.body)) {
+                    ast.stmts[id] = s.forStmt.init ? ast.stmts[s.forStmt.init] : Stmt(STMT_BLOCK);
+                }
+            }
+            break;
+        case STMT_RETURN: {
+            const std::string& returnType = optimizingFunction ? optimizingFunction->returnType : std::string();
+            if (!returnType.empty() && returnType.back() == '&') FoldAddress(s.ret.value);
+            else FoldExpr(s.ret.value);
+            break;
+        }
+        case STMT_EXPR: {
+            FoldExpr(s.expr.expression);
+            // A bare literal or variable read has no effect
+            ExprKind kind = ast.exprs[s.expr.expression].kind;
+            if (kind == EXPR_LITERAL || kind == EXPR_VARIABLE) ast.stmts[id] = Stmt(STMT_BLOCK);
+            break;
+        }
+        case STMT_VAR_DECL: {
+            const std::string& type = ast.Name(s.decl.type);
+            if (!type.empty() && type.back() == '&') FoldAddress(s.decl.initializer);
+            else FoldExpr(s.decl.initializer);
+            FoldExpr(s.decl.arraySize);
+            break;
+        }
+    }
+}
+
+// Folds inside an lvalue without replacing the variable it is rooted at
+void Interpreter::FoldAddress(ExprId id) {
+    if (id == kNoNode) return;
+    const Expr e = ast.exprs[id];
+    switch (e.kind) {
+        case EXPR_VARIABLE:
+            break;
+        case EXPR_MEMBER:
+            FoldAddress(e.member.object);
+            break;
+        case EXPR_INDEX:
+            FoldAddress(e.index.array);
+            FoldExpr(e.index.index);
+            break;
+        default:
+            FoldExpr(id);
+            break;
+    }
+}
+
+void Interpreter::FoldExpr(ExprId id) {
+    if (id == kNoNode) return;
+    const Expr e = ast.exprs[id]; // Copy: the node itself may be replaced below
+    switch (e.kind) {
+        case EXPR_VARIABLE: {
+            if (optimizingLocals.count(e.variable.name)) return;
+            auto c = constGlobals.find(e.variable.name);
+            if (c != constGlobals.end()) {
+                Expr lit(EXPR_LITERAL);
+                lit.literal = c->second;
+                ast.exprs[id] = lit;
+            }
+            return;
+        }
+        case EXPR_BINARY: {
+            FoldExpr(e.binary.left);
+            FoldExpr(e.binary.right);
+            const Expr& left = ast.exprs[e.binary.left];
+            const Expr& right = ast.exprs[e.binary.right];
+            bool leftConst = left.kind == EXPR_LITERAL;
+            bool rightConst = right.kind == EXPR_LITERAL;
+            TokenType op = e.binary.op;
+
+            if (op == TOKEN_AND || op == TOKEN_OR) {
+                // The right side is skipped at run time whenever the left decides
+                bool l, r;
+                if (!ConstantCondition(ast, e.binary.left, l)) return;
+                if (op == TOKEN_AND && !l) ast.exprs[id] = BoolLiteral(false);
+                else if (op == TOKEN_OR && l) ast.exprs[id] = BoolLiteral(true);
+                else if (ConstantCondition(ast, e.binary.right, r)) ast.exprs[id] = BoolLiteral(r);
+                return;
+            }
+            if (!leftConst || !rightConst) return;
+
+            if (LiteralIntegral(left.literal) && LiteralIntegral(right.literal) && op != TOKEN_MOD) {
+                int64_t l = LiteralInt(left.literal);
+                int64_t r = LiteralInt(right.literal);
+                switch (op) {
+                    case TOKEN_PLUS: ast.exprs[id] = IntLiteral(WrapInt(l + r)); break;
+                    case TOKEN_MINUS: ast.exprs[id] = IntLiteral(WrapInt(l - r)); break;
+                    case TOKEN_STAR: ast.exprs[id] = IntLiteral(WrapInt(l * r)); break;
+                    case TOKEN_SLASH: ast.exprs[id] = IntLiteral(r != 0 ? WrapInt(l / r) : 0); break;
+                    case TOKEN_LT: ast.exprs[id] = BoolLiteral(l < r); break;
+                    case TOKEN_GT: ast.exprs[id] = BoolLiteral(l > r); break;
+                    default: break;
+                }
+                return;
+            }
+            float l = LiteralFloat(left.literal);
+            float r = LiteralFloat(right.literal);
+            switch (op) {
+                case TOKEN_PLUS: ast.exprs[id] = NumberLiteral(l + r); break;
+                case TOKEN_MINUS: ast.exprs[id] = NumberLiteral(l - r); break;
+                case TOKEN_STAR: ast.exprs[id] = NumberLiteral(l * r); break;
+                case TOKEN_SLASH: ast.exprs[id] = NumberLiteral(r != 0 ? l / r : 0.0f); break;
+                case TOKEN_LT: ast.exprs[id] = BoolLiteral(l < r); break;
+                case TOKEN_GT: ast.exprs[id] = BoolLiteral(l > r); break;
+                case TOKEN_MOD: {
+                    // The VM computes % on ints whatever the operand types
+                    if (!LiteralFitsInt(left.literal) || !LiteralFitsInt(right.literal)) break;
+                    int li = LiteralInt(left.literal);
+                    int ri = LiteralInt(right.literal);
+                    ast.exprs[id] = IntLiteral(ri != 0 && ri != -1 ? li % ri : 0);
+                    break;
+                }
+                default:
+                    break;
+            }
+            return;
+        }
+        case EXPR_UNARY: {
+            if (e.unary.op == TOKEN_INC || e.unary.op == TOKEN_DEC || e.unary.op == TOKEN_AMPERSAND) {
+                FoldAddress(e.unary.right);
+                return;
+            }
+            FoldExpr(e.unary.right);
+            const Expr& operand = ast.exprs[e.unary.right];
+            if (operand.kind != EXPR_LITERAL) return;
+            bool truthy;
+            Expr cast(EXPR_LITERAL);
+            if (e.unary.op == TOKEN_MINUS && LiteralIntegral(operand.literal)) ast.exprs[id] = IntLiteral(WrapInt(-(int64_t)LiteralInt(operand.literal)));
+            else if (e.unary.op == TOKEN_MINUS) ast.exprs[id] = NumberLiteral(-LiteralFloat(operand.literal));
+            else if (IsCast(e.unary.op) && CastLiteral(operand.literal, CastType(e.unary.op), cast)) ast.exprs[id] = cast;
+            else if (e.unary.op == TOKEN_NOT && ConstantCondition(ast, e.unary.right, truthy)) ast.exprs[id] = BoolLiteral(!truthy);
+            return;
+        }
+        case EXPR_POSTFIX:
+            FoldAddress(e.postfix.left);
+            return;
+        case EXPR_CALL:
+            for (uint32_t i = 0; i < e.call.argCount; i++) {
+                ExprId arg = ast.children[e.call.firstArg + i];
+                if (ArgIsByRef(e.call, i)) FoldAddress(arg);
+                else FoldExpr(arg);
+            }
+            return;
+        case EXPR_MEMBER:
+            FoldAddress(id);
+            return;
+        case EXPR_INDEX:
+            FoldAddress(id);
+            return;
+        case EXPR_ASSIGN:
+            FoldAddress(e.assign.target);
+            FoldExpr(e.assign.value);
+            return;
+        case EXPR_LITERAL:
+            return;
+    }
+}
+
+// --- Inlining ---
+
+static bool Shadows(const std::set<NameId>& callerLocals, const std::set<NameId>& freeNames) {
+    for (NameId name : freeNames) {
+        if (callerLocals.count(name)) return true;
+    }
+    return false;
+}
+
+// `f(args);` as a statement becomes `{ T f.p = arg; ...; <body> }` with the
+// callee's locals renamed to `f.<name>`, so they get their own caller slots
+bool Interpreter::InlineStmt(StmtId id, const std::map<NameId, InlineCandidate>& candidates,
+                             const std::set<NameId>& callerLocals) {
+    if (id == kNoNode) return false;
+    const Stmt s = ast.stmts[id];
+    bool changed = false;
+    switch (s.kind) {
+        case STMT_BLOCK:
+            for (uint32_t i = 0; i < s.block.count; i++) {
+                changed |= InlineStmt(ast.children[s.block.first + i], candidates, callerLocals);
+            }
+            break;
+        case STMT_IF:
+            changed |= InlineExpr(s.ifStmt.condition, candidates, callerLocals);
+            changed |= InlineStmt(s.ifStmt.thenBranch, candidates, callerLocals);
+            changed |= InlineStmt(s.ifStmt.elseBranch, candidates, callerLocals);
+            break;
+        case STMT_WHILE:
+        case STMT_DO_WHILE:
+            changed |= InlineExpr(s.loop.condition, candidates, callerLocals);
+            changed |= InlineStmt(s.loop.body, candidates, callerLocals);
+            break;
+        case STMT_FOR:
+            changed |= InlineStmt(s.forStmt.init, candidates, callerLocals);
+            changed |= InlineExpr(s.forStmt.condition, candidates, callerLocals);
+            changed |= InlineExpr(s.forStmt.increment, candidates, callerLocals);
+            changed |= InlineStmt(s.forStmt.body, candidates, callerLocals);
+            break;
+        case STMT_RETURN:
+            changed |= InlineExpr(s.ret.value, candidates, callerLocals);
+            break;
+        case STMT_VAR_DECL:
+            changed |= InlineExpr(s.decl.initializer, candidates, callerLocals);
+            changed |= InlineExpr(s.decl.arraySize, candidates, callerLocals);
+            break;
+        case STMT_EXPR: {
+            changed |= InlineExpr(s.expr.expression, candidates, callerLocals);
+            const Expr call = ast.exprs[s.expr.expression];
+            if (call.kind != EXPR_CALL) break;
+            auto it = candidates.find(call.call.callee);
+            if (it == candidates.end() || it->second.value != kNoNode) break;
+            const InlineCandidate& candidate = it->second;
+            const FunctionDef& func = *candidate.function;
+            if (call.call.argCount != func.parameters.size() || Shadows(callerLocals, candidate.freeNames)) break;
+
+            std::string prefix = func.name + ".";
+            std::vector<StmtId> stmts;
+            for (uint32_t i = 0; i < call.call.argCount; i++) {
+                Stmt param(STMT_VAR_DECL);
+                param.line = s.line;
+                param.decl.type = ast.Intern(func.parameters[i].first);
+                param.decl.name = ast.Intern(prefix + func.parameters[i].second);
+                param.decl.initializer = ast.children[call.call.firstArg + i];
+                stmts.push_back(ast.Add(param));
+            }
+            const BlockStmt body = ast.stmts[CloneStmt(ast, func.body, prefix, candidate.locals)].block;
+            for (uint32_t i = 0; i < body.count; i++) stmts.push_back(ast.children[body.first + i]);
+            Stmt block(STMT_BLOCK);
+            block.line = s.line;
+            block.block.first = ast.AddChildren(stmts);
+            block.block.count = (uint32_t)stmts.size();
+            ast.stmts[id] = block;
+            changed = true;
+            break;
+        }
+    }
+    return changed;
+}
+
+// `f(args)` where f is `return expr;` becomes expr with the parameters
+// replaced by the arguments. Only done when the arguments are plain reads
+// with no calls, so evaluation order and count cannot be observed. Typed
+// parameters and results keep their conversions as casts.
+bool Interpreter::InlineExpr(ExprId id, const std::map<NameId, InlineCandidate>& candidates,
+                             const std::set<NameId>& callerLocals) {
+    if (id == kNoNode) return false;
+    const Expr e = ast.exprs[id];
+    bool changed = false;
+    switch (e.kind) {
+        case EXPR_BINARY:
+            changed |= InlineExpr(e.binary.left, candidates, callerLocals);
+            changed |= InlineExpr(e.binary.right, candidates, callerLocals);
+            break;
+        case EXPR_UNARY: changed |= InlineExpr(e.unary.right, candidates, callerLocals); break;
+        case EXPR_POSTFIX: changed |= InlineExpr(e.postfix.left, candidates, callerLocals); break;
+        case EXPR_MEMBER: changed |= InlineExpr(e.member.object, candidates, callerLocals); break;
+        case EXPR_INDEX:
+            changed |= InlineExpr(e.index.array, candidates, callerLocals);
+            changed |= InlineExpr(e.index.index, candidates, callerLocals);
+            break;
+        case EXPR_ASSIGN:
+            changed |= InlineExpr(e.assign.target, candidates, callerLocals);
+            changed |= InlineExpr(e.assign.value, candidates, callerLocals);
+            break;
+        case EXPR_CALL: {
+            for (uint32_t i = 0; i < e.call.argCount; i++) {
+                changed |= InlineExpr(ast.children[e.call.firstArg + i], candidates, callerLocals);
+            }
+            auto it = candidates.find(e.call.callee);
+            if (it == candidates.end() || it->second.value == kNoNode) break;
+            const InlineCandidate& candidate = it->second;
+            const FunctionDef& func = *candidate.function;
+            if (e.call.argCount != func.parameters.size() || Shadows(callerLocals, candidate.freeNames)) break;
+
+            std::map<NameId, ExprId> substitutions;
+            bool simple = true;
+            for (uint32_t i = 0; i < e.call.argCount && simple; i++) {
+                ExprId arg = ast.children[e.call.firstArg + i];
+                NameId param = ast.Intern(func.parameters[i].second);
+                int uses = 0;
+                bool plain = true;
+                auto countUses = [&](ExprId n) {
+                    const Expr& x = ast.exprs[n];
+                    if (x.kind == EXPR_VARIABLE && x.variable.name == param) uses++;
+                };
+                auto checkArg = [&](ExprId n) {
+                    const Expr& x = ast.exprs[n];
+                    if (x.kind == EXPR_CALL || x.kind == EXPR_ASSIGN || x.kind == EXPR_POSTFIX || x.kind == EXPR_UNARY) plain = false;
+                };
+                VisitExpr(ast, candidate.value, countUses);
+                VisitExpr(ast, arg, checkArg);
+                ExprKind argKind = ast.exprs[arg].kind;
+                // Reusing a computed argument would evaluate it more than once
+                if (!plain || (uses > 1 && argKind != EXPR_LITERAL && argKind != EXPR_VARIABLE)) simple = false;
+                substitutions[param] = CastTo(arg, TypeOfName(func.parameters[i].first));
+            }
+            if (!simple) break;
+            ExprId body = CastTo(CloneExpr(ast, candidate.value, "", {}, substitutions), TypeOfName(func.returnType));
+            ast.exprs[id] = ast.exprs[body];
+            changed = true;
+            break;
+        }
+        default:
+            break;
+    }
+    return changed;
+}
+
+// A new node converting `id` to `to`; `id` itself if there is nothing to convert to
+ExprId Interpreter::CastTo(ExprId id, StaticType to) {
+    if (to == TYPE_UNKNOWN) return id;
+    Expr cast(EXPR_UNARY);
+    cast.unary.op = to == TYPE_INT ? TOKEN_INT : to == TYPE_FLOAT ? TOKEN_FLOAT : TOKEN_BOOL;
+    cast.unary.right = id;
+    return ast.Add(cast);
+}
+
+// --- Program dump ---
+
+static const char* OperatorText(TokenType op) {
+    switch (op) {
+        case TOKEN_INT: return "(int)";
+        case TOKEN_FLOAT: return "(float)";
+        case TOKEN_BOOL: return "(bool)";
+        case TOKEN_PLUS: return "+";
+        case TOKEN_MINUS: return "-";
+        case TOKEN_STAR: return "*";
+        case TOKEN_SLASH: return "/";
+        case TOKEN_MOD: return "%";
+        case TOKEN_LT: return "<";
+        case TOKEN_GT: return ">";
+        case TOKEN_AND: return "&&";
+        case TOKEN_OR: return "||";
+        case TOKEN_NOT: return "!";
+        case TOKEN_INC: return "++";
+        case TOKEN_DEC: return "--";
+        case TOKEN_AMPERSAND: return "&";
+        default: return "?";
+    }
+}
+
+static void PrintExpr(const Ast& ast, ExprId id, std::ostream& out) {
+    if (id == kNoNode) return;
+    const Expr& e = ast.exprs[id];
+    switch (e.kind) {
+        case EXPR_LITERAL:
+            if (e.literal.isBool) out << (e.literal.boolVal ? "true" : "false");
+            else if (e.literal.isInt) out << e.literal.intVal;
+            else if (e.literal.numberVal == std::floor(e.literal.numberVal) && std::fabs(e.literal.numberVal) < 1e6f) out << e.literal.numberVal << ".0";
+            else out << e.literal.numberVal;
+            break;
+        case EXPR_VARIABLE: out << ast.Name(e.variable.name); break;
+        case EXPR_BINARY:
+            out << "(";
+            PrintExpr(ast, e.binary.left, out);
+            out << " " << OperatorText(e.binary.op) << " ";
+            PrintExpr(ast, e.binary.right, out);
+            out << ")";
+            break;
+        case EXPR_UNARY: out << OperatorText(e.unary.op); PrintExpr(ast, e.unary.right, out); break;
+        case EXPR_POSTFIX: PrintExpr(ast, e.postfix.left, out); out << OperatorText(e.postfix.op); break;
+        case EXPR_CALL:
+            out << ast.Name(e.call.callee) << "(";
+            for (uint32_t i = 0; i < e.call.argCount; i++) {
+                if (i) out << ", ";
+                PrintExpr(ast, ast.children[e.call.firstArg + i], out);
+            }
+            out << ")";
+            break;
+        case EXPR_MEMBER: PrintExpr(ast, e.member.object, out); out << "." << ast.Name(e.member.member); break;
+        case EXPR_INDEX:
+            PrintExpr(ast, e.index.array, out);
+            out << "[";
+            PrintExpr(ast, e.index.index, out);
+            out << "]";
+            break;
+        case EXPR_ASSIGN:
+            PrintExpr(ast, e.assign.target, out);
+            out << " = ";
+            PrintExpr(ast, e.assign.value, out);
+            break;
+    }
+}
+
+static void PrintStmt(const Ast& ast, StmtId id, int indent, std::ostream& out);
+
+// Braced bodies line up with their statement; a single statement is indented
+static void PrintBody(const Ast& ast, StmtId id, int indent, std::ostream& out) {
+    bool braced = id != kNoNode && ast.stmts[id].kind == STMT_BLOCK;
+    PrintStmt(ast, id, braced ? indent : indent + 1, out);
+}
+
+static void PrintStmt(const Ast& ast, StmtId id, int indent, std::ostream& out) {
+    std::string pad(indent * 4, ' ');
+    if (id == kNoNode) { out << pad << ";\n"; return; }
+    const Stmt& s = ast.stmts[id];
+    switch (s.kind) {
+        case STMT_BLOCK:
+            out << pad << "{\n";
+            for (uint32_t i = 0; i < s.block.count; i++) PrintStmt(ast, ast.children[s.block.first + i], indent + 1, out);
+            out << pad << "}\n";
+            break;
+        case STMT_IF:
+            out << pad << "if (";
+            PrintExpr(ast, s.ifStmt.condition, out);
+            out << ")\n";
+            PrintBody(ast, s.ifStmt.thenBranch, indent, out);
+            if (s.ifStmt.elseBranch) {
+                out << pad << "else\n";
+                PrintBody(ast, s.ifStmt.elseBranch, indent, out);
+            }
+            break;
+        case STMT_WHILE:
+            out << pad << "while (";
+            PrintExpr(ast, s.loop.condition, out);
+            out << ")\n";
+            PrintBody(ast, s.loop.body, indent, out);
+            break;
+        case STMT_DO_WHILE:
+            out << pad << "do\n";
+            PrintBody(ast, s.loop.body, indent, out);
+            out << pad << "while (";
+            PrintExpr(ast, s.loop.condition, out);
+            out << ");\n";
+            break;
+        case STMT_FOR:
+            // The init statement is printed ahead of the loop (locals are function-scoped anyway)
+            if (s.forStmt.init) PrintStmt(ast, s.forStmt.init, indent, out);
+            out << pad << "for (; ";
+            PrintExpr(ast, s.forStmt.condition, out);
+            out << "; ";
+            PrintExpr(ast, s.forStmt.increment, out);
+            out << ")\n";
+            PrintBody(ast, s.forStmt.body, indent, out);
+            break;
+        case STMT_RETURN:
+            out << pad << "return";
+            if (s.ret.value) { out << " "; PrintExpr(ast, s.ret.value, out); }
+            out << ";\n";
+            break;
+        case STMT_EXPR:
+            out << pad;
+            PrintExpr(ast, s.expr.expression, out);
+            out << ";\n";
+            break;
+        case STMT_VAR_DECL:
+            out << pad << (s.decl.isConst ? "const " : "") << ast.Name(s.decl.type) << " " << ast.Name(s.decl.name);
+            if (s.decl.isArray) { out << "["; PrintExpr(ast, s.decl.arraySize, out); out << "]"; }
+            if (s.decl.initializer) { out << " = "; PrintExpr(ast, s.decl.initializer, out); }
+            out << ";\n";
+            break;
+    }
+}
+
+void Interpreter::DumpProgram(std::ostream& out, const char* title) {
+    out << "// ---- " << title << " ----\n";
+    const BlockStmt& globals = ast.stmts[globalInit.body].block;
+    for (uint32_t i = 0; i < globals.count; i++) PrintStmt(ast, ast.children[globals.first + i], 0, out);
+    for (auto& entry : functions) {
+        const FunctionDef& func = entry.second;
+        out << "\n" << func.returnType << " " << func.name << "(";
+        for (size_t i = 0; i < func.parameters.size(); i++) {
+            if (i) out << ", ";
+            out << func.parameters[i].first << " " << func.parameters[i].second;
+        }
+        out << ")\n";
+        PrintStmt(ast, func.body, 0, out);
+    }
+    out << std::endl;
+}
@@ -0,0 +1,67 @@
+#include "PinBank.h"
+#include <cmath>
+
+PinBank::PinBank() : sequence(0) {
+    Clear();
+}
+
+void PinBank::Clear() {
+    uint32_t seq = sequence.load(std::memory_order_relaxed);
+    sequence.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (int i = 0; i < kPinCount; i++) {
+        pins[i].store(0, std::memory_order_relaxed);
+        sensors[i].store(NAN, std::memory_order_relaxed);
+        sensorSequences[i].store(0, std::memory_order_relaxed);
+    }
+    sequence.store(seq + 2, std::memory_order_release);
+}
+
+int PinBank::ReadPin(int pin) const {
+    return InRange(pin) ? pins[pin].load(std::memory_order_relaxed) : 0;
+}
+
+void PinBank::WritePin(int pin, int value) {
+    WritePins(pin, &value, 1);
+}
+
+void PinBank::WritePins(int firstPin, const int* values, int count) {
+    // Odd sequence = write in progress; readers retry until it is even again
+    uint32_t seq = sequence.load(std::memory_order_relaxed);
+    sequence.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (int i = 0; i < count; i++) {
+        if (InRange(firstPin + i)) pins[firstPin + i].store(values[i], std::memory_order_relaxed);
+    }
+    sequence.store(seq + 2, std::memory_order_release);
+}
+
+uint32_t PinBank::Sequence() const {
+    return sequence.load(std::memory_order_acquire);
+}
+
+uint32_t PinBank::ReadPins(int firstPin, int count, int* out) const {
+    for (;;) {
+        uint32_t before = sequence.load(std::memory_order_acquire);
+        if (before & 1) continue;
+        for (int i = 0; i < count; i++) {
+            out[i] = InRange(firstPin + i) ? pins[firstPin + i].load(std::memory_order_relaxed) : 0;
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence.load(std::memory_order_relaxed) == before) return before;
+    }
+}
+
+bool PinBank::ReadSensor(int echoPin, float& distance, uint32_t& pinSequence) const {
+    if (!InRange(echoPin)) return false;
+    // The distance stored before the stamp is at least as new as it
+    pinSequence = sensorSequences[echoPin].load(std::memory_order_acquire);
+    distance = sensors[echoPin].load(std::memory_order_relaxed);
+    return !std::isnan(distance);
+}
+
+void PinBank::WriteSensor(int echoPin, float distance, uint32_t pinSequence) {
+    if (!InRange(echoPin)) return;
+    sensors[echoPin].store(distance, std::memory_order_relaxed);
+    sensorSequences[echoPin].store(pinSequence, std::memory_order_release);
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+// Fixed-size pin and sensor storage shared between the script thread and the
+// render loop without a lock.
+//
+// Pins are written by the script thread only. Writes go through a sequence
+// counter (a seqlock), so a reader taking a range with ReadPins() always sees
+// the state between two complete writes: a motor command that sets pins 8-11
+// together is never observed half applied. Sensors are written by the
+// simulation thread only and read one at a time. Each reading carries the
+// sequence of the pin snapshot it was simulated from, so the script can tell
+// whether it already reflects its last command.
+class PinBank {
+public:
+    static const int kPinCount = 70; // Arduino Mega: D0-D53, A0-A15
+
+    PinBank();
+
+    void Clear();
+
+    // --- Script thread ---
+    int ReadPin(int pin) const;
+    void WritePin(int pin, int value);
+    void WritePins(int firstPin, const int* values, int count); // Published as one update
+    uint32_t Sequence() const;                                  // Of the last completed write
+    // False until the first WriteSensor; `pinSequence` is the reading's stamp
+    bool ReadSensor(int echoPin, float& distance, uint32_t& pinSequence) const;
+
+    // --- Simulation thread ---
+    uint32_t ReadPins(int firstPin, int count, int* out) const; // Consistent snapshot; returns its sequence
+    void WriteSensor(int echoPin, float distance, uint32_t pinSequence);
+
+private:
+    static bool InRange(int pin) { return pin >= 0 && pin < kPinCount; }
+
+    std::atomic<uint32_t> sequence;
+    std::atomic<int> pins[kPinCount];
+    std::atomic<float> sensors[kPinCount]; // NaN = no echo wired to this pin
+    std::atomic<uint32_t> sensorSequences[kPinCount];
+};
@@ -0,0 +1,346 @@
+#include "ProgramCache.h"
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <initializer_list>
+#include <type_traits>
+
+static_assert(std::is_trivially_copyable<Stmt>::value && std::is_trivially_copyable<Expr>::value,
+              "Cache files store AST nodes as raw bytes");
+
+// Cache file: a header, then the payload the header hashes. AST nodes are
+// stored as raw bytes, so the header also carries a fingerprint of their
+// layout; a file written by a build with another layout or byte order is
+// skipped. Bump kFileVersion whenever the AST or the payload format changes:
+// the fingerprint catches moved fields and added kinds, not changed meanings.
+static const uint32_t kFileMagic = 0x4350524D; // "MRPC"
+static const uint32_t kFileVersion = 2;
+
+// FNV-1a over 64-bit words, at compile time
+static constexpr uint64_t Fingerprint(std::initializer_list<uint64_t> words) {
+    uint64_t hash = 14695981039346656037ull;
+    for (uint64_t word : words) {
+        for (int shift = 0; shift < 64; shift += 8) {
+            hash ^= (word >> shift) & 0xff;
+            hash *= 1099511628211ull;
+        }
+    }
+    return hash;
+}
+
+static constexpr uint64_t kLayout = Fingerprint({
+    kFileVersion, kTokenTypeCount, kStmtKindCount, kExprKindCount,
+    sizeof(Stmt), offsetof(Stmt, line), offsetof(Stmt, raw),
+    sizeof(Expr), offsetof(Expr, type), offsetof(Expr, raw),
+    // Statement payloads
+    offsetof(BlockStmt, first), offsetof(BlockStmt, count),
+    offsetof(IfStmt, condition), offsetof(IfStmt, thenBranch), offsetof(IfStmt, elseBranch),
+    offsetof(WhileStmt, condition), offsetof(WhileStmt, body),
+    offsetof(ForStmt, init), offsetof(ForStmt, condition), offsetof(ForStmt, increment), offsetof(ForStmt, body),
+    offsetof(ReturnStmt, value), offsetof(ExprStmt, expression),
+    offsetof(VarDeclStmt, type), offsetof(VarDeclStmt, name), offsetof(VarDeclStmt, initializer),
+    offsetof(VarDeclStmt, arraySize), offsetof(VarDeclStmt, isArray), offsetof(VarDeclStmt, isConst),
+    offsetof(VarDeclStmt, slot),
+    // Expression payloads
+    offsetof(BinaryExpr, left), offsetof(BinaryExpr, op), offsetof(BinaryExpr, right),
+    offsetof(UnaryExpr, op), offsetof(UnaryExpr, right),
+    offsetof(PostfixExpr, left), offsetof(PostfixExpr, op),
+    offsetof(LiteralExpr, numberVal), offsetof(LiteralExpr, intVal), offsetof(LiteralExpr, boolVal),
+    offsetof(LiteralExpr, isBool), offsetof(LiteralExpr, isInt),
+    offsetof(VariableExpr, name), offsetof(VariableExpr, slot), offsetof(VariableExpr, isGlobal),
+    offsetof(CallExpr, callee), offsetof(CallExpr, firstArg), offsetof(CallExpr, argCount),
+    offsetof(CallExpr, function), offsetof(CallExpr, builtin),
+    offsetof(MemberExpr, object), offsetof(MemberExpr, member),
+    offsetof(IndexExpr, array), offsetof(IndexExpr, index),
+    offsetof(AssignExpr, target), offsetof(AssignExpr, value),
+});
+
+struct FileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t layout;     // kLayout of the writing build
+    uint64_t variant;
+    uint64_t payloadHash;
+    uint64_t payloadSize;
+};
+
+// --- Serialization ---
+
+namespace {
+
+class Writer {
+public:
+    std::string data;
+
+    void Bytes(const void* p, size_t n) { data.append((const char*)p, n); }
+    template <typename T> void Pod(const T& v) { Bytes(&v, sizeof(T)); }
+    template <typename T> void PodVector(const std::vector<T>& v) {
+        Pod((uint32_t)v.size());
+        Bytes(v.data(), v.size() * sizeof(T));
+    }
+    void String(const std::string& s) {
+        Pod((uint32_t)s.size());
+        Bytes(s.data(), s.size());
+    }
+    void Function(const FunctionDef& f) {
+        String(f.name);
+        String(f.returnType);
+        Pod((uint32_t)f.parameters.size());
+        for (auto& param : f.parameters) {
+            String(param.first);
+            String(param.second);
+        }
+        Pod(f.body);
+    }
+};
+
+// Every read checks the remaining length; a short or garbled file sets `ok`
+class Reader {
+public:
+    Reader(const char* p, size_t n) : p(p), end(p + n) {}
+    bool ok = true;
+
+    bool Bytes(void* out, size_t n) {
+        if (!ok || (size_t)(end - p) < n) return ok = false;
+        memcpy(out, p, n);
+        p += n;
+        return true;
+    }
+    template <typename T> T Pod() {
+        T v{};
+        Bytes(&v, sizeof(T));
+        return v;
+    }
+    template <typename T> void PodVector(std::vector<T>& v) {
+        uint32_t n = Pod<uint32_t>();
+        if (!ok || (size_t)(end - p) / sizeof(T) < n) {
+            ok = false;
+            return;
+        }
+        // Nodes have no default constructor; copy each through an aligned buffer
+        v.clear();
+        v.reserve(n);
+        for (uint32_t i = 0; i < n; i++) {
+            alignas(T) unsigned char item[sizeof(T)];
+            memcpy(item, p, sizeof(T));
+            v.push_back(*reinterpret_cast<const T*>(item));
+            p += sizeof(T);
+        }
+    }
+    std::string String() {
+        uint32_t n = Pod<uint32_t>();
+        if (!ok || (size_t)(end - p) < n) {
+            ok = false;
+            return std::string();
+        }
+        std::string s(p, n);
+        p += n;
+        return s;
+    }
+    FunctionDef Function() {
+        FunctionDef f;
+        f.name = String();
+        f.returnType = String();
+        uint32_t params = Pod<uint32_t>();
+        for (uint32_t i = 0; ok && i < params; i++) {
+            std::string type = String();
+            f.parameters.push_back({type, String()});
+        }
+        f.body = Pod<StmtId>();
+        return f;
+    }
+    bool AtEnd() const { return ok && p == end; }
+
+private:
+    const char* p;
+    const char* end;
+};
+
+} // namespace
+
+static std::string Serialize(const std::string& source, const ParsedProgram& program) {
+    Writer w;
+    w.String(source);
+    w.PodVector(program.ast.stmts);
+    w.PodVector(program.ast.exprs);
+    w.PodVector(program.ast.children);
+    w.Pod((uint32_t)program.ast.names.size());
+    for (auto& name : program.ast.names) w.String(name);
+    w.Pod((uint32_t)program.functions.size());
+    for (auto& entry : program.functions) w.Function(entry.second);
+    w.Pod((uint32_t)program.structs.size());
+    for (auto& entry : program.structs) {
+        w.String(entry.second.name);
+        w.Pod((uint32_t)entry.second.members.size());
+        for (auto& member : entry.second.members) {
+            w.String(member.first);
+            w.String(member.second);
+        }
+    }
+    w.Pod((uint32_t)program.enums.size());
+    for (auto& entry : program.enums) {
+        w.String(entry.second.name);
+        w.Pod((uint32_t)entry.second.values.size());
+        for (auto& value : entry.second.values) {
+            w.String(value.first);
+            w.Pod(value.second);
+        }
+    }
+    w.Function(program.globalInit);
+    return w.data;
+}
+
+// Null if the payload is not a complete program for `source`
+static std::shared_ptr<ParsedProgram> Deserialize(const std::string& payload, const std::string& source) {
+    Reader r(payload.data(), payload.size());
+    if (r.String() != source || !r.ok) return nullptr;
+    auto program = std::make_shared<ParsedProgram>();
+    Ast& ast = program->ast;
+    r.PodVector(ast.stmts);
+    r.PodVector(ast.exprs);
+    r.PodVector(ast.children);
+    uint32_t names = r.Pod<uint32_t>();
+    ast.names.clear();
+    for (uint32_t i = 0; r.ok && i < names; i++) ast.Intern(r.String());
+    if (ast.names.size() != names) return nullptr; // Duplicates: ids would shift
+    uint32_t functions = r.Pod<uint32_t>();
+    for (uint32_t i = 0; r.ok && i < functions; i++) {
+        FunctionDef f = r.Function();
+        program->functions[f.name] = f;
+    }
+    uint32_t structs = r.Pod<uint32_t>();
+    for (uint32_t i = 0; r.ok && i < structs; i++) {
+        StructDef def;
+        def.name = r.String();
+        uint32_t members = r.Pod<uint32_t>();
+        for (uint32_t j = 0; r.ok && j < members; j++) {
+            std::string name = r.String();
+            def.members[name] = r.String();
+        }
+        program->structs[def.name] = def;
+    }
+    uint32_t enums = r.Pod<uint32_t>();
+    for (uint32_t i = 0; r.ok && i < enums; i++) {
+        EnumDef def;
+        def.name = r.String();
+        uint32_t values = r.Pod<uint32_t>();
+        for (uint32_t j = 0; r.ok && j < values; j++) {
+            std::string name = r.String();
+            def.values[name] = r.Pod<int>();
+        }
+        program->enums[def.name] = def;
+    }
+    program->globalInit = r.Function();
+    if (!r.AtEnd()) return nullptr;
+    return program;
+}
+
+// --- ProgramCache ---
+
+ProgramCache::ProgramCache(const std::string& directory, size_t capacity)
+    : directory(directory), capacity(capacity) {
+    if (!directory.empty()) {
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+    }
+}
+
+uint64_t ProgramCache::Hash(std::string_view data, uint64_t seed) {
+    uint64_t hash = seed;
+    for (unsigned char c : data) {
+        hash ^= c;
+        hash *= 1099511628211ull; // FNV-1a prime
+    }
+    return hash;
+}
+
+uint64_t ProgramCache::Key(const std::string& source, uint64_t variant) {
+    return Hash(source) ^ (variant * 0x9E3779B97F4A7C15ull);
+}
+
+std::shared_ptr<const ParsedProgram> ProgramCache::Find(const std::string& source, uint64_t variant) {
+    uint64_t key = Key(source, variant);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(key);
+        if (it != entries.end()) {
+            const Entry& entry = it->second;
+            if (entry.variant == variant && entry.source == source) return entry.program;
+            return nullptr;
+        }
+    }
+    if (directory.empty()) return nullptr;
+    auto program = ReadFile(key, source, variant);
+    if (!program) return nullptr;
+    std::lock_guard<std::mutex> lock(mutex);
+    Add(key, Entry{source, variant, program});
+    return program;
+}
+
+void ProgramCache::Insert(const std::string& source, uint64_t variant, std::shared_ptr<const ParsedProgram> program) {
+    uint64_t key = Key(source, variant);
+    Entry entry{source, variant, std::move(program)};
+    if (!directory.empty()) WriteFile(key, entry);
+    std::lock_guard<std::mutex> lock(mutex);
+    Add(key, std::move(entry));
+}
+
+// Caller holds the lock
+void ProgramCache::Add(uint64_t key, Entry entry) {
+    auto it = entries.find(key);
+    if (it != entries.end()) {
+        it->second = std::move(entry);
+        return;
+    }
+    entries.emplace(key, std::move(entry));
+    insertionOrder.push_back(key);
+    while (entries.size() > capacity) {
+        entries.erase(insertionOrder.front());
+        insertionOrder.pop_front();
+    }
+}
+
+std::string ProgramCache::FilePath(uint64_t key) const {
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.mrp", (unsigned long long)key);
+    return (std::filesystem::path(directory) / name).string();
+}
+
+std::shared_ptr<const ParsedProgram> ProgramCache::ReadFile(uint64_t key, const std::string& source, uint64_t variant) const {
+    std::string path = FilePath(key);
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return nullptr;
+    FileHeader header;
+    if (!file.read((char*)&header, sizeof(header))) return nullptr;
+    if (header.magic != kFileMagic || header.version != kFileVersion || header.layout != kLayout ||
+        header.variant != variant) {
+        return nullptr;
+    }
+    // The size comes from the file: check it against the file before allocating it
+    std::error_code error;
+    uintmax_t fileSize = std::filesystem::file_size(path, error);
+    if (error || header.payloadSize != fileSize - sizeof(header)) return nullptr;
+    std::string payload(header.payloadSize, '\0');
+    if (!file.read(&payload[0], payload.size()) || Hash(payload) != header.payloadHash) return nullptr;
+    return Deserialize(payload, source);
+}
+
+void ProgramCache::WriteFile(uint64_t key, const Entry& entry) const {
+    std::string payload = Serialize(entry.source, *entry.program);
+    FileHeader header = { kFileMagic, kFileVersion, kLayout, entry.variant, Hash(payload), payload.size() };
+    // Written aside and renamed, so a concurrent reader never sees half a file
+    std::string path = FilePath(key);
+    std::string temp = path + ".tmp" + std::to_string((uintptr_t)this);
+    {
+        std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+        if (!file) return;
+        file.write((const char*)&header, sizeof(header));
+        file.write(payload.data(), payload.size());
+        if (!file) return;
+    }
+    std::error_code error;
+    std::filesystem::rename(temp, path, error);
+    if (error) std::filesystem::remove(temp, error);
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include "Interpreter.h"
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// What Interpreter::Load() gets out of the front end (tokenizer, parser and
+// optimizer) before binding it to its own builtins: the input of Resolve()
+// and Compile().
+struct ParsedProgram {
+    Ast ast;
+    std::map<std::string, FunctionDef> functions;
+    std::map<std::string, StructDef, std::less<>> structs;
+    std::map<std::string, EnumDef, std::less<>> enums;
+    FunctionDef globalInit;
+};
+
+// Parsed programs keyed by a hash of their source, shared by every
+// interpreter attached with Interpreter::SetProgramCache(), so loading a
+// script that was loaded before skips the front end. Thread-safe.
+//
+// With a directory, entries are also written there in a compact binary form
+// and read back on a miss, so they outlive the process. Files from another
+// build whose AST layout differs are ignored.
+class ProgramCache {
+public:
+    explicit ProgramCache(const std::string& directory = "", size_t capacity = 64);
+
+    // `variant` tells apart front-end settings that change the result for
+    // the same source (optimizer on or off, by-reference builtins)
+    std::shared_ptr<const ParsedProgram> Find(const std::string& source, uint64_t variant);
+    void Insert(const std::string& source, uint64_t variant, std::shared_ptr<const ParsedProgram> program);
+
+    static uint64_t Hash(std::string_view data, uint64_t seed = kHashSeed);
+    // Entries and files are keyed by this; distinct pairs can collide
+    static uint64_t Key(const std::string& source, uint64_t variant);
+
+private:
+    static const uint64_t kHashSeed = 14695981039346656037ull; // FNV-1a offset basis
+
+    struct Entry {
+        std::string source;
+        uint64_t variant;
+        std::shared_ptr<const ParsedProgram> program;
+    };
+
+    void Add(uint64_t key, Entry entry);
+    std::string FilePath(uint64_t key) const;
+    std::shared_ptr<const ParsedProgram> ReadFile(uint64_t key, const std::string& source, uint64_t variant) const;
+    void WriteFile(uint64_t key, const Entry& entry) const;
+
+    std::string directory;
+    size_t capacity;
+    std::mutex mutex;
+    std::unordered_map<uint64_t, Entry> entries; // A colliding source replaces the entry
+    std::deque<uint64_t> insertionOrder; // Oldest first; evicted past `capacity`
+};
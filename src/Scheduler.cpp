@@ -0,0 +1,118 @@
+#include "Scheduler.h"
+#include "Interpreter.h"
+#include <algorithm>
+
+Scheduler::Scheduler(int workerCount) {
+    if (workerCount <= 0) workerCount = (int)std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 0; i < workerCount; i++) workers.emplace_back(&Scheduler::WorkerLoop, this);
+}
+
+Scheduler::~Scheduler() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        shuttingDown = true;
+    }
+    workAvailable.notify_all();
+    for (auto& worker : workers) worker.join();
+}
+
+void Scheduler::Submit(Interpreter* script) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        Task& task = tasks[script];
+        task.generation = nextGeneration++;
+        MakeReady(script, task);
+    }
+    workAvailable.notify_one();
+}
+
+void Scheduler::Remove(Interpreter* script) {
+    std::unique_lock<std::mutex> lock(mutex);
+    // A running Step() returns promptly once Stop() cleared isRunning; the
+    // worker then finishes the run itself
+    taskStopped.wait(lock, [&] {
+        auto it = tasks.find(script);
+        return it == tasks.end() || it->second.state != TASK_RUNNING;
+    });
+    auto it = tasks.find(script);
+    if (it == tasks.end()) return;
+    // Queue and timer entries for it are skipped from now on
+    tasks.erase(it);
+    script->FinishRun();
+}
+
+// Caller holds the lock
+void Scheduler::MakeReady(Interpreter* script, Task& task) {
+    task.state = TASK_READY;
+    ready.push_back({script, task.generation});
+}
+
+// Caller holds the lock
+bool Scheduler::Current(const QueueEntry& entry, TaskState state) {
+    auto it = tasks.find(entry.script);
+    return it != tasks.end() && it->second.generation == entry.generation && it->second.state == state;
+}
+
+void Scheduler::Wake(Interpreter* script, uint64_t generation) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!Current({script, generation}, TASK_PARKED)) return;
+        MakeReady(script, tasks[script]);
+    }
+    workAvailable.notify_one();
+}
+
+void Scheduler::WorkerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        if (shuttingDown) return;
+
+        auto now = std::chrono::steady_clock::now();
+        size_t woken = 0;
+        while (!timers.empty() && timers.top().due <= now) {
+            Timer timer = timers.top();
+            timers.pop();
+            if (!Current({timer.script, timer.generation}, TASK_PARKED)) continue;
+            MakeReady(timer.script, tasks[timer.script]);
+            woken++;
+        }
+        // This worker takes one; idle workers share the rest
+        for (size_t i = 1; i < woken; i++) workAvailable.notify_one();
+        if (ready.empty()) {
+            if (timers.empty()) workAvailable.wait(lock);
+            else workAvailable.wait_until(lock, timers.top().due);
+            continue;
+        }
+
+        QueueEntry entry = ready.front();
+        ready.pop_front();
+        if (!Current(entry, TASK_READY)) continue;
+        Interpreter* script = entry.script;
+        tasks[script].state = TASK_RUNNING;
+
+        lock.unlock();
+        Interpreter::StepResult result = script->Step();
+        lock.lock();
+
+        // Remove() waits while the task runs, so it is still registered
+        Task& task = tasks[script];
+        if (result == Interpreter::STEP_DONE) {
+            tasks.erase(script);
+            script->FinishRun();
+        } else if (result == Interpreter::STEP_YIELD) {
+            MakeReady(script, task);
+        } else {
+            task.state = TASK_PARKED;
+            task.generation = nextGeneration++;
+            uint64_t generation = task.generation;
+            int64_t micros = script->sleepMicros;
+            bool parked = script->clock->ParkFor(micros, [this, script, generation] { Wake(script, generation); });
+            if (!parked) {
+                timers.push({std::chrono::steady_clock::now() + std::chrono::microseconds(micros), script, generation});
+                // Idle workers may be waiting for a later timer
+                if (timers.top().generation == generation) workAvailable.notify_one();
+            }
+        }
+        taskStopped.notify_all();
+    }
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+class Interpreter;
+
+// Runs many interpreters on a fixed pool of worker threads (M:N). A script
+// only holds a worker while it executes: delay(), turns and idle polling
+// park it, on a timer heap for REAL_TIME clocks or on its SimClock for
+// SIMULATED ones, until it is due. Busy scripts go back to the end of the
+// ready queue after every slice so they share the workers.
+//
+// Attach an interpreter with Interpreter::SetScheduler() before Start();
+// stop every attached interpreter before destroying the scheduler.
+class Scheduler {
+public:
+    explicit Scheduler(int workerCount = 0); // 0: one per hardware thread
+    ~Scheduler();
+
+    int WorkerCount() const { return (int)workers.size(); }
+
+private:
+    friend class Interpreter;
+
+    // --- Interpreter::Start() / Stop() ---
+    void Submit(Interpreter* script);
+    // Waits until no worker runs `script`, then forgets it. Its run is
+    // finished (wake action, ScriptFinished) unless it already ended.
+    void Remove(Interpreter* script);
+
+    enum TaskState { TASK_READY, TASK_RUNNING, TASK_PARKED };
+    struct Task {
+        TaskState state = TASK_READY;
+        uint64_t generation = 0; // Queue and timer entries of older parks are stale
+    };
+    struct QueueEntry {
+        Interpreter* script;
+        uint64_t generation;
+    };
+    struct Timer {
+        std::chrono::steady_clock::time_point due;
+        Interpreter* script;
+        uint64_t generation;
+        bool operator>(const Timer& other) const { return due > other.due; }
+    };
+
+    void WorkerLoop();
+    void Wake(Interpreter* script, uint64_t generation); // SimClock wake callback
+    bool Current(const QueueEntry& entry, TaskState state);
+    void MakeReady(Interpreter* script, Task& task);
+
+    std::mutex mutex;
+    std::condition_variable workAvailable;
+    std::condition_variable taskStopped; // A task left TASK_RUNNING
+    std::unordered_map<Interpreter*, Task> tasks;
+    std::deque<QueueEntry> ready;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers;
+    uint64_t nextGeneration = 1;
+    bool shuttingDown = false;
+    std::vector<std::thread> workers;
+};
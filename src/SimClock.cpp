@@ -0,0 +1,103 @@
+#include "SimClock.h"
+#include <cassert>
+
+SimClock::SimClock() : mode(REAL_TIME), simMicros(0) {
+    epoch = std::chrono::steady_clock::now();
+}
+
+void SimClock::Reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+    epoch = std::chrono::steady_clock::now();
+    simMicros = 0;
+    wakeMicros = 0;
+    parkedWake = nullptr;
+}
+
+void SimClock::SetMode(Mode m) {
+    mode = m;
+}
+
+int64_t SimClock::NowMicros() const {
+    if (mode == SIMULATED) return simMicros;
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - epoch).count();
+}
+
+void SimClock::ScriptStarted() {
+    std::lock_guard<std::mutex> lock(mutex);
+    scriptState = SCRIPT_RUNNING;
+}
+
+void SimClock::ScriptFinished() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        scriptState = SCRIPT_DETACHED;
+        parkedWake = nullptr;
+    }
+    cv.notify_all();
+}
+
+void SimClock::SleepFor(int64_t micros, const std::atomic<bool>& running) {
+    if (micros <= 0) return;
+    if (mode == REAL_TIME) {
+        // A timed wait rather than sleep_for, so Interrupt() ends it at once
+        auto until = std::chrono::steady_clock::now() + std::chrono::microseconds(micros);
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait_until(lock, until, [&] { return !running; });
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    wakeMicros = simMicros + micros;
+    scriptState = SCRIPT_SLEEPING;
+    cv.notify_all();
+    // AdvanceTo() flips us back to SCRIPT_RUNNING when the wake time is reached
+    cv.wait(lock, [&] { return scriptState != SCRIPT_SLEEPING || !running; });
+    if (scriptState == SCRIPT_SLEEPING) scriptState = SCRIPT_RUNNING;
+}
+
+bool SimClock::ParkFor(int64_t micros, std::function<void()> wake) {
+    if (mode == REAL_TIME) return false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        assert(!parkedWake && "SimClock shared by two parked scripts");
+        wakeMicros = simMicros + micros;
+        scriptState = SCRIPT_SLEEPING;
+        parkedWake = std::move(wake);
+    }
+    cv.notify_all();
+    return true;
+}
+
+void SimClock::Interrupt() {
+    { std::lock_guard<std::mutex> lock(mutex); }
+    cv.notify_all();
+}
+
+int64_t SimClock::WaitForScriptIdle(std::chrono::steady_clock::time_point deadline) {
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait_until(lock, deadline, [&] { return scriptState != SCRIPT_RUNNING; });
+    switch (scriptState) {
+        case SCRIPT_SLEEPING: return wakeMicros;
+        case SCRIPT_DETACHED: return INT64_MAX;
+        default: return simMicros;
+    }
+}
+
+void SimClock::AdvanceTo(int64_t micros) {
+    bool wake = false;
+    std::function<void()> parked;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        simMicros = micros;
+        if (scriptState == SCRIPT_SLEEPING && simMicros >= wakeMicros) {
+            scriptState = SCRIPT_RUNNING;
+            parked = std::move(parkedWake);
+            parkedWake = nullptr;
+            wake = true;
+        }
+    }
+    if (wake) cv.notify_all();
+    // Outside the lock: the callback takes the scheduler's lock
+    if (parked) parked();
+}
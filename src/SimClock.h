@@ -0,0 +1,63 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+
+// Time base shared by an Interpreter and the Simulation driving it.
+//
+// REAL_TIME: time is the wall clock since Reset() and sleeps block the
+// script thread for real, until Interrupt() cuts them short.
+// SIMULATED: time only moves when the simulation calls AdvanceTo(). A
+// sleeping script parks until simulated time reaches its wake time, and the
+// simulation never advances past that wake time while the script is
+// running, so both sides see the same sequence of events as a real-time run.
+//
+// A clock tracks one script: its state, wake time and parked wake callback
+// are single slots. Interpreters sharing a Scheduler each need their own.
+class SimClock {
+public:
+    enum Mode { REAL_TIME, SIMULATED };
+
+    SimClock();
+
+    void Reset(); // Time 0, keeps the mode
+    void SetMode(Mode m);
+    Mode GetMode() const { return mode; }
+    int64_t NowMicros() const;
+
+    // --- Script thread ---
+    void ScriptStarted();
+    void ScriptFinished();
+    void SleepFor(int64_t micros, const std::atomic<bool>& running);
+    void Interrupt(); // Wakes a parked SleepFor after `running` was cleared
+
+    // Non-blocking SleepFor for scripts run by a Scheduler. In SIMULATED mode
+    // the script is marked sleeping and `wake` is called (on the thread that
+    // calls AdvanceTo) once simulated time reaches the wake time; returns
+    // false in REAL_TIME mode, where the caller waits on the wall clock itself.
+    // The previous park must have been woken: one parked script per clock.
+    bool ParkFor(int64_t micros, std::function<void()> wake);
+
+    // --- Simulation thread (SIMULATED mode) ---
+    // Waits until the script is parked (or the deadline passes) and returns the
+    // time the simulation may advance to. Returns NowMicros() if the script is
+    // still executing, INT64_MAX if no script is attached.
+    int64_t WaitForScriptIdle(std::chrono::steady_clock::time_point deadline);
+    void AdvanceTo(int64_t micros);
+
+private:
+    enum ScriptState { SCRIPT_DETACHED, SCRIPT_RUNNING, SCRIPT_SLEEPING };
+
+    std::atomic<Mode> mode;
+    std::chrono::steady_clock::time_point epoch;
+    std::atomic<int64_t> simMicros;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    ScriptState scriptState = SCRIPT_DETACHED;
+    int64_t wakeMicros = 0;
+    std::function<void()> parkedWake; // Set by ParkFor until AdvanceTo wakes it
+};
@@ -1,9 +1,14 @@
 #include "Simulation.h"
-#include "raymath.h"
-#include "rlgl.h"
+#include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <iostream>
 #include <sstream>
 
+// Frame time beyond this is dropped rather than caught up in one burst
+static const int64_t kMaxFrameMicros = 250000;
+static const float kDegToRad = 3.14159265358979f / 180.0f;
+
 Simulation::Simulation() {
     currentMaze = nullptr;
 }
@@ -25,18 +30,143 @@ void Simulation::Init(const MazeGenerator& maze, const std::string& code) {
     robot.rotation = -90.0f; // Facing Up
     robot.speedLeft = 0;
     robot.speedRight = 0;
-    
+    previousRobot = robot;
+    stats = Stats();
+    colliding = false;
+    accumulatorMicros = 0;
+    renderAlpha = 1.0f;
+    
+    // Lockstep time is always virtual: Update() paces it to real time unless fast-forwarding
+    clock.SetMode(useSimulatedTime || useLockstep ? SimClock::SIMULATED : SimClock::REAL_TIME);
+    interpreter.SetClock(&clock);
+    interpreter.SetProgramCache(sharedProgramCache ? sharedProgramCache : &ownProgramCache);
+    interpreter.SetLockstep(useLockstep);
+    interpreter.SetSensorSource([this](int echoPin, float& distance, uint32_t& pinSequence) {
+        return ReadEcho(echoPin, distance, pinSequence);
+    });
+    interpreter.SetDigitalSource([this](int pin, int& level) { return ReadDigital(pin, level); });
+    interpreter.SetScanSource([this](float* distances, int capacity, uint32_t& pinSequence) {
+        return ReadScan(distances, capacity, pinSequence);
+    });
+    interpreter.SetProgramDump(dumpProgram ? &std::cout : nullptr);
     interpreter.Load(code);
-    interpreter.Start(); // Start the thread
+    MountSensors(); // Same pose, but maybe a new maze or rig
+    ReadPins();
+    PublishPose(); // Before the script's first pulseIn()
+    interpreter.Start(); // Starts the thread, unless running in lockstep
+}
+
+void Simulation::Reload(const MazeGenerator& maze, const std::string& code) {
+    if (currentMaze != &maze || !interpreter.IsRunning()) {
+        Init(maze, code);
+        return;
+    }
+    currentCode = code;
+    interpreter.Reload(code);
 }
 
-void Simulation::Update() {
+void Simulation::Update(float frameTime) {
     if (!currentMaze) return;
     
-    UpdatePhysics();
+    if (useLockstep) {
+        UpdateLockstep(frameTime);
+        return;
+    }
+    if (clock.GetMode() == SimClock::SIMULATED) {
+        UpdateSimulatedTime(frameTime);
+        return;
+    }
+    
     // ExecuteCode is now running in a thread.
-    // We just read the pins in UpdatePhysics (or separate function).
-    ReadPins();
+    // Catch physics up with the wall clock in fixed steps, each driven by the
+    // script's latest command; the remainder carries over to the next frame
+    for (int64_t micros = ConsumeFrameTime(frameTime); micros > 0; micros -= physicsStepMicros) {
+        StepPhysics();
+    }
+}
+
+int64_t Simulation::ConsumeFrameTime(float frameTime) {
+    accumulatorMicros = std::min(accumulatorMicros + (int64_t)(frameTime * 1e6f), kMaxFrameMicros);
+    int64_t whole = accumulatorMicros - accumulatorMicros % physicsStepMicros;
+    accumulatorMicros -= whole;
+    renderAlpha = (float)accumulatorMicros / physicsStepMicros;
+    return whole;
+}
+
+void Simulation::UpdateSimulatedTime(float frameTime) {
+    // Advance the virtual clock a physics step at a time while the script
+    // sleeps, until this frame's wall-time budget is spent. A script that is
+    // computing holds simulated time still until it sleeps again.
+    auto deadline = std::chrono::steady_clock::now() +
+                    std::chrono::microseconds((int64_t)(simulatedFrameBudget * 1e6f));
+    int64_t frameMicros = ConsumeFrameTime(frameTime);
+    renderAlpha = 1.0f; // Frames end on a step
+    
+    while (std::chrono::steady_clock::now() < deadline) {
+        int64_t limit = clock.WaitForScriptIdle(deadline);
+        int64_t now = clock.NowMicros();
+        if (limit == INT64_MAX) {
+            // No script attached: just keep real-time pace
+            for (int64_t end = now + frameMicros; now < end; now += physicsStepMicros) {
+                StepPhysics();
+                clock.AdvanceTo(now + physicsStepMicros);
+            }
+            break;
+        }
+        if (limit <= now) break;
+        
+        StepPhysics();
+        clock.AdvanceTo(now + physicsStepMicros);
+    }
+}
+
+void Simulation::UpdateLockstep(float frameTime) {
+    // Real-time pace advances by the frame time; fast-forward goes as far as
+    // the frame budget allows
+    auto deadline = std::chrono::steady_clock::now() +
+                    std::chrono::microseconds((int64_t)(simulatedFrameBudget * 1e6f));
+    int64_t frameMicros = ConsumeFrameTime(frameTime);
+    if (useSimulatedTime) {
+        AdvanceLockstep(INT64_MAX, frameMicros, deadline);
+        renderAlpha = 1.0f;
+        return;
+    }
+    int64_t target = clock.NowMicros() + frameMicros;
+    AdvanceLockstep(target, frameMicros, deadline);
+    // Steps a computing script held back are owed to the next frame
+    int64_t behind = target - clock.NowMicros();
+    if (behind > 0) {
+        accumulatorMicros = std::min(accumulatorMicros + behind, kMaxFrameMicros);
+        renderAlpha = 1.0f;
+    }
+}
+
+void Simulation::RunUntil(int64_t untilMicros, std::chrono::steady_clock::time_point deadline) {
+    if (!currentMaze || !useLockstep) return;
+    AdvanceLockstep(untilMicros, physicsStepMicros, deadline);
+}
+
+void Simulation::AdvanceLockstep(int64_t target, int64_t idleMicros, std::chrono::steady_clock::time_point deadline) {
+    // Same stepping as UpdateSimulatedTime(), but the script runs right here
+    // instead of on its own thread, at every step it is due. Steps never
+    // depend on frame or CPU timing, so a run is the same at any pace. Once
+    // the script has stopped, time moves on by `idleMicros` per call.
+    while (std::chrono::steady_clock::now() < deadline) {
+        int64_t limit = interpreter.RunLockstep(deadline);
+        int64_t now = clock.NowMicros();
+        if (limit == INT64_MAX) {
+            // Script stopped: just keep real-time pace
+            for (int64_t end = std::min(target, now + idleMicros); now < end; now += physicsStepMicros) {
+                StepPhysics();
+                clock.AdvanceTo(now + physicsStepMicros);
+            }
+            break;
+        }
+        if (limit <= now || now >= target) break;
+        
+        StepPhysics();
+        clock.AdvanceTo(now + physicsStepMicros);
+    }
 }
 
 void Simulation::ReadPins() {
@@ -46,10 +176,12 @@ void Simulation::ReadPins() {
     // IN3 = 10, IN4 = 11 (Right Motor?)
     // ENA = 12, ENB = 13
     
-    int in1 = interpreter.GetPinValue(8);
-    int in2 = interpreter.GetPinValue(9);
-    int in3 = interpreter.GetPinValue(10);
-    int in4 = interpreter.GetPinValue(11);
+    int motor[4];
+    pinSequence = interpreter.GetPinValues(8, 4, motor); // One consistent motor command
+    int in1 = motor[0];
+    int in2 = motor[1];
+    int in3 = motor[2];
+    int in4 = motor[3];
     
     // Logic:
     // Forward: IN1 High, IN2 Low
@@ -68,9 +200,27 @@ void Simulation::ReadPins() {
     robot.speedRight = rightSpeed;
 }
 
-void Simulation::UpdatePhysics() {
-    float dt = GetFrameTime();
-    
+void Simulation::StepPhysics() {
+    previousRobot = robot;
+    ReadPins();
+    // A simulated clock is advanced past the step once it is done; the wall clock already is
+    stepEndMicros = clock.NowMicros() + (clock.GetMode() == SimClock::SIMULATED ? physicsStepMicros : 0);
+    float dt = physicsStepMicros / 1e6f / physicsSubsteps;
+    for (int i = 0; i < physicsSubsteps; i++) UpdatePhysics(dt);
+    // Sensors are raycast when read
+    PublishPose();
+}
+
+Simulation::Robot Simulation::RenderPose() const {
+    Robot pose = robot;
+    pose.position.x = previousRobot.position.x + (robot.position.x - previousRobot.position.x) * renderAlpha;
+    pose.position.y = previousRobot.position.y + (robot.position.y - previousRobot.position.y) * renderAlpha;
+    pose.rotation = previousRobot.rotation + (robot.rotation - previousRobot.rotation) * renderAlpha;
+    return pose;
+}
+
+void Simulation::UpdatePhysics(float dt) {
+
     // Movement
     float speed = (robot.speedLeft + robot.speedRight) / 2.0f;
     float rotSpeed = (robot.speedRight - robot.speedLeft) / 2.0f; // Differential steering
@@ -81,11 +231,11 @@ void Simulation::UpdatePhysics() {
     
     robot.rotation += rotSpeed * rotSpeedScale * dt;
     
-    Vector2 forward = { cosf(DEG2RAD * robot.rotation), sinf(DEG2RAD * robot.rotation) };
-    Vector2 move = Vector2Scale(forward, speed * moveSpeedScale * dt);
+    float distance = speed * moveSpeedScale * dt;
+    Vec2 move = { cosf(kDegToRad * robot.rotation) * distance, sinf(kDegToRad * robot.rotation) * distance };
     
     // Proposed new position
-    Vector2 nextPos = Vector2Add(robot.position, move);
+    Vec2 nextPos = { robot.position.x + move.x, robot.position.y + move.y };
     
     // Collision Detection
     float radius = 0.3f; 
@@ -110,98 +260,109 @@ void Simulation::UpdatePhysics() {
     
     if (!collision) {
         robot.position = nextPos;
+        stats.distance += fabsf(distance);
+    } else if (!colliding) {
+        stats.collisions++;
     }
+    colliding = collision;
     
-    // Sensors (Raycast)
-    float unitsPerCell = 40.0f; // cm per cell?
-    
-    Vector2 forwardDir = { cosf(DEG2RAD * robot.rotation), sinf(DEG2RAD * robot.rotation) };
-    Vector2 leftDir = { cosf(DEG2RAD * (robot.rotation - 90)), sinf(DEG2RAD * (robot.rotation - 90)) };
-    Vector2 rightDir = { cosf(DEG2RAD * (robot.rotation + 90)), sinf(DEG2RAD * (robot.rotation + 90)) };
-    
-    float frontDistVal = CastRay(robot.position, forwardDir) * unitsPerCell;
-    float leftDistVal = CastRay(robot.position, leftDir) * unitsPerCell;
-    float rightDistVal = CastRay(robot.position, rightDir) * unitsPerCell;
-    
-    frontDist = frontDistVal;
-    leftDist = leftDistVal;
-    rightDist = rightDistVal;
-    
-    // Inject variables
-    // User code uses: distF, distL, distR (globals)
-    // But it also calls readSensors() which calls readUltrasonic().
-    // readUltrasonic calls pulseIn.
-    // pulseIn reads sensorValues.
-    
-    // We need to set sensorValues for pulseIn to work.
-    // User code:
-    // trigF=2, echoF=3
-    // trigL=4, echoL=5
-    // trigR=6, echoR=7
-    
-    interpreter.SetSensorValue(2, 3, frontDist);
-    interpreter.SetSensorValue(4, 5, leftDist);
-    interpreter.SetSensorValue(6, 7, rightDist);
-    
-    // Also set globals if user code uses them directly (optional, but user code reads them via readSensors)
-    // The user code: distF = readUltrasonic(...)
-    // So we don't need to set distF directly.
+    if (!stats.reachedGoal && (int)robot.position.x == currentMaze->ExitX() &&
+        (int)robot.position.y == currentMaze->ExitY()) {
+        stats.reachedGoal = true;
+        stats.goalMicros = stepEndMicros; // When the pose that reached it is current
+    }
 }
 
-float Simulation::CastRay(Vector2 start, Vector2 dir) {
-    float dist = 0.0f;
-    float step = 0.05f; 
-    float maxDist = 5.0f; 
-    
-    Vector2 currentPos = start;
-    
-    while (dist < maxDist) {
-        Vector2 nextPos = Vector2Add(currentPos, Vector2Scale(dir, step));
-        
-        int cx = (int)currentPos.x;
-        int cy = (int)currentPos.y;
-        int nx = (int)nextPos.x;
-        int ny = (int)nextPos.y;
-        
-        const Cell* cell = currentMaze->GetCell(cx, cy);
-        if (!cell) return dist; 
-        
-        if (cx != nx) {
-            if (nx > cx) { if (cell->wallEast) return dist; }
-            else { if (cell->wallWest) return dist; }
+void Simulation::PublishPose() {
+    std::lock_guard<std::mutex> lock(sensorMutex);
+    if (robot.position.x != sensorPosition.x || robot.position.y != sensorPosition.y ||
+        robot.rotation != sensorRotation) {
+        sensorPosition = robot.position;
+        sensorRotation = robot.rotation;
+        for (MountedSensor& sensor : rig) sensor.cached = false;
+    }
+    // Readings of an unchanged pose still count as taken under the new command
+    sensorSequence = pinSequence;
+}
+
+void Simulation::MountSensors() {
+    std::lock_guard<std::mutex> lock(sensorMutex);
+    rig.clear();
+    beamX.clear();
+    beamY.clear();
+    for (const SensorMount& mount : sensors) {
+        int beams = mount.kind == SensorMount::LIDAR ? std::max(mount.beams, 1) : 1;
+        rig.push_back({ mount, (int)beamX.size(), beams, false, false });
+        for (int i = 0; i < beams; i++) {
+            float angle = kDegToRad * (mount.angle + 360.0f * i / beams);
+            beamX.push_back(cosf(angle));
+            beamY.push_back(sinf(angle));
         }
-        
-        if (cy != ny) {
-            if (ny > cy) { if (cell->wallSouth) return dist; }
-            else { if (cell->wallNorth) return dist; }
+    }
+    rayX.resize(beamX.size());
+    rayY.resize(beamY.size());
+    readings.resize(beamX.size());
+}
+
+int Simulation::ReadSensor(int index, float* out, int capacity, uint32_t* pinSequence) {
+    std::lock_guard<std::mutex> lock(sensorMutex);
+    if (pinSequence) *pinSequence = sensorSequence;
+    MountedSensor& sensor = rig[index];
+    int first = sensor.firstBeam;
+    if (!sensor.cached) {
+        // Turn the beams to the pose, then cast them together
+        float c = cosf(kDegToRad * sensorRotation);
+        float s = sinf(kDegToRad * sensorRotation);
+        for (int i = first; i < first + sensor.beamCount; i++) {
+            rayX[i] = beamX[i] * c - beamY[i] * s;
+            rayY[i] = beamX[i] * s + beamY[i] * c;
         }
-        
-        if (!currentMaze->GetCell(nx, ny)) return dist;
-        
-        currentPos = nextPos;
-        dist += step;
+        currentMaze->Walls().CastRays(sensorPosition, &rayX[first], &rayY[first], sensor.beamCount, sensor.mount.range, &readings[first]);
+        for (int i = first; i < first + sensor.beamCount; i++) readings[i] *= kUnitsPerCell;
+        sensor.cached = true;
+        sensor.everCast = true;
     }
-    
-    return maxDist;
+    int count = std::min(capacity, sensor.beamCount);
+    std::copy(readings.begin() + first, readings.begin() + first + count, out);
+    return sensor.beamCount;
 }
 
-void Simulation::Draw() {
-    if (!currentMaze) return;
-    
-    Vector2 screenPos = currentMaze->GetScreenPos(robot.position.x, robot.position.y);
-    float cellSize = currentMaze->GetRenderCellSize();
-    float robotSize = cellSize * 0.3f; 
-    
-    DrawCircleV(screenPos, robotSize, RED);
-    
-    Vector2 forward = { cosf(DEG2RAD * robot.rotation), sinf(DEG2RAD * robot.rotation) };
-    DrawLineV(screenPos, Vector2Add(screenPos, Vector2Scale(forward, robotSize * 1.5f)), BLACK);
-    
-    int screenW = GetScreenWidth();
-    DrawText("Sensor Values:", screenW - 200, 20, 20, BLACK);
-    DrawText(TextFormat("Front: %.1f", frontDist), screenW - 200, 50, 20, BLUE);
-    DrawText(TextFormat("Left:  %.1f", leftDist), screenW - 200, 80, 20, BLUE);
-    DrawText(TextFormat("Right: %.1f", rightDist), screenW - 200, 110, 20, BLUE);
+int Simulation::PeekSensor(int index, float* out, int capacity) {
+    std::lock_guard<std::mutex> lock(sensorMutex);
+    const MountedSensor& sensor = rig[index];
+    if (!sensor.everCast) return 0;
+    int count = std::min(capacity, sensor.beamCount);
+    std::copy(readings.begin() + sensor.firstBeam, readings.begin() + sensor.firstBeam + count, out);
+    return count;
+}
+
+int Simulation::FindSensor(SensorMount::Kind kind, int pin) const {
+    for (size_t i = 0; i < rig.size(); i++) {
+        if (rig[i].mount.kind == kind && (kind == SensorMount::LIDAR || rig[i].mount.pin == pin)) return (int)i;
+    }
+    return -1;
+}
+
+bool Simulation::ReadEcho(int echoPin, float& distance, uint32_t& pinSequence) {
+    int index = FindSensor(SensorMount::ULTRASONIC, echoPin);
+    if (index < 0) return false;
+    ReadSensor(index, &distance, 1, &pinSequence);
+    return true;
+}
+
+bool Simulation::ReadDigital(int pin, int& level) {
+    int index = FindSensor(SensorMount::IR, pin);
+    if (index < 0) return false;
+    float distance;
+    ReadSensor(index, &distance, 1);
+    level = distance < rig[index].mount.range * kUnitsPerCell ? 0 : 1; // Active low, like common IR modules
+    return true;
+}
+
+int Simulation::ReadScan(float* distances, int capacity, uint32_t& pinSequence) {
+    int index = FindSensor(SensorMount::LIDAR, -1);
+    if (index < 0) return 0;
+    return ReadSensor(index, distances, capacity, &pinSequence);
 }
 
 void Simulation::ExecuteCode() {
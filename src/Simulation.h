@@ -1,42 +1,139 @@
 #pragma once
 #include "MazeGenerator.h"
 #include "Interpreter.h"
-#include "raylib.h"
+#include "ProgramCache.h"
+#include "SimClock.h"
+#include "Vec2.h"
+#include <chrono>
+#include <mutex>
 #include <string>
+#include <vector>
 
 class Simulation {
 public:
     Simulation();
     
     void Init(const MazeGenerator& maze, const std::string& code);
-    void Update();
-    void Draw();
+    // Swaps in edited code without restarting: the robot stays where it is and
+    // the script continues from its next loop() with compatible globals kept
+    // (see Interpreter::Reload). Starts afresh if nothing is running.
+    void Reload(const MazeGenerator& maze, const std::string& code);
+    void Update(float frameTime); // Wall seconds since the last frame
+    void Draw();                  // SimulationDraw.cpp, raylib builds only
+    
+    // Headless stepping, lockstep only: runs the script and physics until the
+    // simulated clock reaches `untilMicros`, the script stops, or the
+    // wall-clock deadline passes
+    void RunUntil(int64_t untilMicros, std::chrono::steady_clock::time_point deadline);
+    int64_t SimTimeMicros() const { return clock.NowMicros(); }
+    bool IsScriptRunning() const { return interpreter.IsRunning(); }
+    std::string GetScriptError() { return interpreter.GetRuntimeError(); }
     
     // Robot State
     struct Robot {
-        Vector2 position; // Grid coordinates
+        Vec2 position;    // Grid coordinates
         float rotation;   // Degrees (0 = East, 90 = South)
         float speedLeft;
         float speedRight;
     };
     Robot robot;
     
-    float frontDist;
-    float leftDist;
-    float rightDist;
+    // Since Init()
+    struct Stats {
+        float distance = 0.0f;      // Cells travelled
+        int collisions = 0;         // Times a move was stopped by a wall
+        bool reachedGoal = false;   // Entered the maze's exit cell
+        int64_t goalMicros = -1;    // Simulated time it first did
+    };
+    Stats stats;
+    
+    static constexpr float kUnitsPerCell = 40.0f; // Sensor readings are in cm
+    
+    // A sensor on the robot. Scripts read ultrasonic units with
+    // pulseIn(pin), IR proximity sensors with digitalRead(pin), which is LOW
+    // while a wall is within range, and the first lidar with lidar(array).
+    struct SensorMount {
+        enum Kind { ULTRASONIC, IR, LIDAR };
+        Kind kind;
+        int pin;            // Echo pin (ultrasonic) or output pin (IR); unused by a lidar
+        float angle;        // Degrees clockwise from the robot's front; a lidar's first beam
+        float range = 5.0f; // Cells; farther walls read as this far
+        int beams = 1;      // Lidar: spread evenly clockwise over 360 degrees
+    };
     
     // Config
     float stepDelay = 1.0f; // Seconds per step
+    bool useSimulatedTime = false; // Run on the virtual clock, as fast as the CPU allows
+    bool useLockstep = false; // Run the script on this thread between physics steps: reproducible runs
+    float simulatedFrameBudget = 0.010f; // Wall seconds per frame spent advancing simulated time
+    bool dumpProgram = false; // Print the script before and after optimization to stdout on Init
+    int64_t physicsStepMicros = 1000; // Fixed physics step; simulated time advances in whole steps
+    int physicsSubsteps = 1; // Integration and collision checks per physics step
+    // Parsed programs shared with other simulations and, given a directory,
+    // with later runs; null uses a private in-memory cache. Takes effect on Init().
+    ProgramCache* sharedProgramCache = nullptr;
+    // The robot's sensors; takes effect on Init()
+    std::vector<SensorMount> sensors = {
+        { SensorMount::ULTRASONIC, 3, 0.0f },   // Front
+        { SensorMount::ULTRASONIC, 5, -90.0f }, // Left
+        { SensorMount::ULTRASONIC, 7, 90.0f },  // Right
+        { SensorMount::LIDAR, -1, 0.0f, 5.0f, 360 },
+    };
     
 private:
     const MazeGenerator* currentMaze;
     std::string currentCode;
+    
+    // Sensors are raycast only when a script or the HUD reads them, from the
+    // pose the last physics step published, and cached until the robot moves.
+    // The HUD draws lidars from their last scan and never casts one itself.
+    // All beams of a sensor are cast as one batch on the maze's WallGrid.
+    // Declared before the interpreter, whose thread reads them.
+    struct MountedSensor {
+        SensorMount mount;
+        int firstBeam; // Into beamX, beamY and readings
+        int beamCount;
+        bool cached;
+        bool everCast; // `readings` hold a cast, maybe from an older pose
+    };
+    std::mutex sensorMutex;
+    std::vector<MountedSensor> rig;  // `sensors` as of Init()
+    std::vector<float> beamX, beamY; // Unit beam directions with the robot facing East
+    std::vector<float> rayX, rayY;   // The same, turned to the published pose
+    std::vector<float> readings;     // Per beam, in script units (cm)
+    Vec2 sensorPosition = { 0, 0 };
+    float sensorRotation = 0.0f;
+    uint32_t sensorSequence = 0; // Pin sequence of the command the pose was reached under
+    SimClock clock; // Declared before the interpreter, which uses it until it is destroyed
+    ProgramCache ownProgramCache; // Restarting an unchanged script skips parsing
     Interpreter interpreter;
     
     float executionTimer = 0.0f;
+    bool colliding = false; // The last move was blocked
+    Robot previousRobot; // Before the last physics step; Draw() interpolates from it
+    float renderAlpha = 1.0f; // How far Draw() is between previousRobot and robot
+    int64_t accumulatorMicros = 0; // Frame time not yet simulated, less than a step
+    int64_t stepEndMicros = 0; // Clock time the physics step being taken ends at
+    uint32_t pinSequence = 0; // Of the motor command the robot is driving with; stamps sensor readings
     
-    void UpdatePhysics();
+    void UpdateSimulatedTime(float frameTime);
+    void UpdateLockstep(float frameTime);
+    void AdvanceLockstep(int64_t target, int64_t idleMicros, std::chrono::steady_clock::time_point deadline);
+    int64_t ConsumeFrameTime(float frameTime); // Whole steps' worth of frame time plus what was left over
+    void StepPhysics();
+    void UpdatePhysics(float dt);
+    Robot RenderPose() const;
     void ExecuteCode();
     void ReadPins();
-    float CastRay(Vector2 start, Vector2 dir);
+    void PublishPose();
+    void MountSensors();
+    // Copies up to `capacity` readings of rig[index]; returns its beam count
+    int ReadSensor(int index, float* out, int capacity, uint32_t* pinSequence = nullptr);
+    // Copies rig[index]'s last readings without casting; 0 if it was never read
+    int PeekSensor(int index, float* out, int capacity);
+    int FindSensor(SensorMount::Kind kind, int pin) const; // Index into rig, -1 if none; any pin for a lidar
+    // Interpreter sources
+    bool ReadEcho(int echoPin, float& distance, uint32_t& pinSequence);
+    bool ReadDigital(int pin, int& level);
+    int ReadScan(float* distances, int capacity, uint32_t& pinSequence);
 };
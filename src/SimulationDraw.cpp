@@ -0,0 +1,50 @@
+#include "Simulation.h"
+#include "raylib.h"
+#include "raymath.h"
+#include <cmath>
+#include <vector>
+
+void Simulation::Draw() {
+    if (!currentMaze) return;
+    
+    Robot pose = RenderPose(); // Between the last two physics steps, so motion is smooth at any frame rate
+    Vec2 gridPos = currentMaze->GetScreenPos(pose.position.x, pose.position.y);
+    Vector2 screenPos = { gridPos.x, gridPos.y };
+    float cellSize = currentMaze->GetRenderCellSize();
+    float robotSize = cellSize * 0.3f; 
+    
+    DrawCircleV(screenPos, robotSize, RED);
+    
+    Vector2 forward = { cosf(DEG2RAD * pose.rotation), sinf(DEG2RAD * pose.rotation) };
+    DrawLineV(screenPos, Vector2Add(screenPos, Vector2Scale(forward, robotSize * 1.5f)), BLACK);
+    
+    // Lidar returns as dots; the other sensors as readouts
+    int screenW = GetScreenWidth();
+    int textY = 20;
+    DrawText("Sensor Values:", screenW - 200, textY, 20, BLACK);
+    std::vector<float> distances;
+    for (int i = 0; i < (int)rig.size(); i++) {
+        const SensorMount& mount = rig[i].mount;
+        distances.resize(rig[i].beamCount);
+        if (mount.kind == SensorMount::LIDAR) {
+            // The last scan the script took: drawing alone never casts a full scan
+            int beams = PeekSensor(i, distances.data(), (int)distances.size());
+            for (int beam = 0; beam < beams; beam++) {
+                float angle = DEG2RAD * (pose.rotation + mount.angle + 360.0f * beam / rig[i].beamCount);
+                float cells = distances[beam] / kUnitsPerCell;
+                Vec2 hit = currentMaze->GetScreenPos(pose.position.x + cosf(angle) * cells, pose.position.y + sinf(angle) * cells);
+                DrawCircleV({ hit.x, hit.y }, 1.5f, ORANGE);
+            }
+            continue;
+        }
+        ReadSensor(i, distances.data(), 1);
+        const char* label = mount.kind == SensorMount::IR ? "IR" : "Echo";
+        textY += 30;
+        DrawText(TextFormat("%s %d (%+.0f): %.1f", label, mount.pin, mount.angle, distances[0]), screenW - 200, textY, 20, BLUE);
+    }
+    
+    std::string error = interpreter.GetRuntimeError();
+    if (!error.empty()) {
+        DrawText(TextFormat("Script stopped: %s", error.c_str()), 10, GetScreenHeight() - 30, 20, RED);
+    }
+}
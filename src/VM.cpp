@@ -0,0 +1,378 @@
+#include "Interpreter.h"
+#include <cstring>
+
+// --- VM ---
+// Executes Interpreter::code. Script calls push a StackFrame and jump; they
+// never recurse on the native stack, so Run() can return in the middle of a
+// call chain and be resumed later from resumeIp.
+
+static Value MakeRef(Value* target) {
+    if (target && target->type == VAL_REF && target->refVal) target = target->refVal;
+    return Value::Ref(target);
+}
+
+// The aggregate an element address points into. Writers get an unshared
+// copy; a bound reference also pins it so no later copy shares the storage
+// it points at.
+static Aggregate* ContainerFor(Value& v, AccessMode mode) {
+    if (mode == ACCESS_READ) return v.object;
+    Aggregate* agg = v.Unshare();
+    if (mode == ACCESS_BIND) agg->pinned = true;
+    return agg;
+}
+
+// Collapses a VAL_REF into a copy of what it points at
+static Value Deref(Value v) {
+    if (v.type != VAL_REF) return v;
+    if (!v.refVal) return Value();
+    return *v.refVal;
+}
+
+// The _I instructions wrap at 32 bits, computed unsigned to stay defined
+static inline int Wrap(uint32_t v) { return (int)v; }
+
+template <typename Op>
+static inline void IntBinary(std::vector<Value>& stack, Op op) {
+    Value& l = stack[stack.size() - 2];
+    const Value& r = stack.back();
+    if (l.type == VAL_INT && r.type == VAL_INT) l.intVal = op(l.intVal, r.intVal);
+    else l = Value(op(l.AsInt(), r.AsInt()));
+    stack.pop_back();
+}
+
+template <typename Op>
+static inline void IntCompare(std::vector<Value>& stack, Op op) {
+    Value& l = stack[stack.size() - 2];
+    const Value& r = stack.back();
+    if (l.type == VAL_INT && r.type == VAL_INT) {
+        bool result = op(l.intVal, r.intVal);
+        l.raw = 0;
+        l.boolVal = result;
+        l.type = VAL_BOOL;
+    } else {
+        l = Value(op(l.AsInt(), r.AsInt()));
+    }
+    stack.pop_back();
+}
+
+void Interpreter::PushFrame(const FunctionDef& func, int returnAddress, size_t stackBase) {
+    StackFrame frame;
+    frame.function = &func;
+    frame.returnAddress = returnAddress;
+    frame.stackBase = stackBase;
+    if (!slotPool.empty()) {
+        frame.locals = std::move(slotPool.back());
+        slotPool.pop_back();
+    }
+    frame.locals.assign(func.localCount, Value());
+    callStack.push_back(std::move(frame));
+}
+
+void Interpreter::PopFrame() {
+    // Release the slots now: a pooled copy would keep aggregates shared and
+    // force the caller's next write to copy them
+    callStack.back().locals.clear();
+    slotPool.push_back(std::move(callStack.back().locals));
+    callStack.pop_back();
+}
+
+// Idle time charged to a slice that only spun or polled
+static const int64_t kIdleSleepMicros = 1000;
+
+// A slice that changed nothing (`while(true);`) or kept reading the clock or
+// a sensor is busy-waiting on hardware: sleep so the core (and, in simulated
+// time, the robot) can move on. Compute-heavy slices only yield, which lets
+// scripts sharing a scheduler take turns.
+void Interpreter::EndSlice() {
+    bool idle = sliceEffects == 0 || slicePolled;
+    sliceRemaining = kSliceIterations;
+    sliceEffects = 0;
+    slicePolled = false;
+    yieldRequested = true;
+    sleepMicros = idle ? kIdleSleepMicros : 0;
+}
+
+void Interpreter::RuntimeError(const std::string& message, int ip) {
+    {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        runtimeError = message + " at line " + std::to_string(codeLines[ip]);
+    }
+    isRunning = false;
+}
+
+Value Interpreter::Invoke(const FunctionDef& func) {
+    if (func.entry < 0) return Value();
+    size_t baseDepth = callStack.size();
+    PushFrame(func, -1, valueStack.size());
+    return Run(func.entry, baseDepth);
+}
+
+Value Interpreter::Run(int ip, size_t baseDepth) {
+    auto pop = [this]() {
+        Value v = std::move(valueStack.back());
+        valueStack.pop_back();
+        return v;
+    };
+
+    for (;;) {
+        const Instr& ins = code[ip++];
+        switch (ins.op) {
+            case OP_PUSH_NUM: {
+                float f;
+                std::memcpy(&f, &ins.a, sizeof(f));
+                valueStack.push_back(Value(f));
+                break;
+            }
+            case OP_PUSH_INT:
+                valueStack.push_back(Value((int)ins.a));
+                break;
+            case OP_PUSH_BOOL:
+                valueStack.push_back(Value(ins.a != 0));
+                break;
+            case OP_PUSH_VOID:
+                valueStack.push_back(Value());
+                break;
+            case OP_PUSH_DEFAULT:
+                valueStack.push_back(CreateDefaultValue(names[ins.a]));
+                break;
+            case OP_NEW_ARRAY: {
+                int size = pop().AsInt();
+                Value arr = Value::MakeAggregate(VAL_ARRAY);
+                if (size > 0) arr.object->arrayElements.assign(size, CreateDefaultValue(names[ins.a]));
+                valueStack.push_back(std::move(arr));
+                break;
+            }
+            case OP_POP:
+                valueStack.pop_back();
+                break;
+
+            case OP_LOAD_LOCAL:
+            case OP_LOAD_GLOBAL: {
+                Value* v = ins.op == OP_LOAD_LOCAL ? &callStack.back().locals[ins.a] : &globals[ins.a];
+                if (v->type == VAL_REF && v->refVal) v = v->refVal;
+                valueStack.push_back(*v);
+                break;
+            }
+            case OP_ADDR_LOCAL:
+                valueStack.push_back(MakeRef(&callStack.back().locals[ins.a]));
+                break;
+            case OP_ADDR_GLOBAL:
+                valueStack.push_back(MakeRef(&globals[ins.a]));
+                break;
+            case OP_PUSH_NULL_REF:
+                valueStack.push_back(MakeRef(nullptr));
+                break;
+            case OP_DECL_LOCAL:
+            case OP_DECL_GLOBAL: {
+                Value val = pop();
+                bool isRef = ins.b != 0;
+                if (!isRef || val.type != VAL_REF || !val.refVal) val = Deref(std::move(val));
+                sliceEffects++;
+                if (ins.op == OP_DECL_LOCAL) {
+                    callStack.back().locals[ins.a] = std::move(val);
+                } else {
+                    std::lock_guard<std::mutex> lock(memoryMutex);
+                    globals[ins.a] = std::move(val);
+                }
+                break;
+            }
+
+            case OP_ADDR_MEMBER: {
+                Value ref = pop();
+                Value* obj = ref.type == VAL_REF ? ref.refVal : nullptr;
+                if (obj && obj->type == VAL_REF && obj->refVal) obj = obj->refVal;
+                Value* member = nullptr;
+                if (obj && obj->type == VAL_STRUCT) {
+                    auto& members = ContainerFor(*obj, (AccessMode)ins.b)->members;
+                    if (ins.b == ACCESS_READ) {
+                        // Reads must not insert into a container other Values share
+                        auto it = members.find(names[ins.a]);
+                        if (it != members.end()) member = &it->second;
+                    } else {
+                        member = &members[names[ins.a]];
+                    }
+                }
+                valueStack.push_back(MakeRef(member));
+                break;
+            }
+            case OP_ADDR_INDEX: {
+                int idx = pop().AsInt();
+                Value ref = pop();
+                Value* arr = ref.type == VAL_REF ? ref.refVal : nullptr;
+                if (arr && arr->type == VAL_REF && arr->refVal) arr = arr->refVal;
+                Value* elem = nullptr;
+                if (arr && arr->type == VAL_ARRAY && idx >= 0 && idx < (int)arr->object->arrayElements.size()) {
+                    elem = &ContainerFor(*arr, (AccessMode)ins.b)->arrayElements[idx];
+                }
+                valueStack.push_back(MakeRef(elem));
+                break;
+            }
+            case OP_LOAD_REF: {
+                Value& top = valueStack.back();
+                top = Deref(std::move(top));
+                break;
+            }
+            case OP_STORE: {
+                Value val = Deref(pop());
+                Value ref = pop();
+                if (ref.type == VAL_REF && ref.refVal) *ref.refVal = val;
+                sliceEffects++;
+                valueStack.push_back(std::move(val));
+                break;
+            }
+            case OP_PRE_INC:
+            case OP_PRE_DEC:
+            case OP_POST_INC:
+            case OP_POST_DEC: {
+                Value ref = pop();
+                Value* target = ref.type == VAL_REF ? ref.refVal : nullptr;
+                if (!target) {
+                    valueStack.push_back(Value());
+                    break;
+                }
+                sliceEffects++;
+                Value old = *target;
+                int delta = (ins.op == OP_PRE_INC || ins.op == OP_POST_INC) ? 1 : -1;
+                if (target->type == VAL_FLOAT) *target = Value(target->floatVal + delta);
+                else if (!target->IsAggregate()) *target = Value(target->AsInt() + delta);
+                valueStack.push_back((ins.op == OP_PRE_INC || ins.op == OP_PRE_DEC) ? *target : std::move(old));
+                break;
+            }
+
+            // Binary operators combine the top two slots in place
+            case OP_ADD: { Value& l = valueStack[valueStack.size() - 2]; l = Value(l.AsFloat() + valueStack.back().AsFloat()); valueStack.pop_back(); break; }
+            case OP_SUB: { Value& l = valueStack[valueStack.size() - 2]; l = Value(l.AsFloat() - valueStack.back().AsFloat()); valueStack.pop_back(); break; }
+            case OP_MUL: { Value& l = valueStack[valueStack.size() - 2]; l = Value(l.AsFloat() * valueStack.back().AsFloat()); valueStack.pop_back(); break; }
+            case OP_DIV: {
+                Value& l = valueStack[valueStack.size() - 2];
+                float divisor = valueStack.back().AsFloat();
+                l = Value(divisor != 0 ? l.AsFloat() / divisor : 0.0f);
+                valueStack.pop_back();
+                break;
+            }
+            case OP_MOD: {
+                Value& l = valueStack[valueStack.size() - 2];
+                int divisor = valueStack.back().AsInt();
+                // x % -1 is 0, and INT_MIN % -1 would trap
+                l = Value(divisor != 0 && divisor != -1 ? l.AsInt() % divisor : 0);
+                valueStack.pop_back();
+                break;
+            }
+            case OP_LT: { Value& l = valueStack[valueStack.size() - 2]; l = Value(l.AsFloat() < valueStack.back().AsFloat()); valueStack.pop_back(); break; }
+            case OP_GT: { Value& l = valueStack[valueStack.size() - 2]; l = Value(l.AsFloat() > valueStack.back().AsFloat()); valueStack.pop_back(); break; }
+            case OP_NEG: {
+                Value& top = valueStack.back();
+                top = Value(-top.AsFloat());
+                break;
+            }
+            case OP_NOT: {
+                Value& top = valueStack.back();
+                top = Value(!top.IsTruthy());
+                break;
+            }
+            // Statically int operands are nearly always VAL_INT already, so the
+            // result is written over the left slot without rebuilding a Value
+            case OP_ADD_I: IntBinary(valueStack, [](int l, int r) { return Wrap((uint32_t)l + (uint32_t)r); }); break;
+            case OP_SUB_I: IntBinary(valueStack, [](int l, int r) { return Wrap((uint32_t)l - (uint32_t)r); }); break;
+            case OP_MUL_I: IntBinary(valueStack, [](int l, int r) { return Wrap((uint32_t)l * (uint32_t)r); }); break;
+            case OP_DIV_I:
+                // Truncates toward zero; INT_MIN / -1 wraps instead of trapping
+                IntBinary(valueStack, [](int l, int r) { return r == 0 ? 0 : r == -1 ? Wrap(0u - (uint32_t)l) : l / r; });
+                break;
+            case OP_LT_I: IntCompare(valueStack, [](int l, int r) { return l < r; }); break;
+            case OP_GT_I: IntCompare(valueStack, [](int l, int r) { return l > r; }); break;
+            case OP_NEG_I: {
+                Value& top = valueStack.back();
+                if (top.type == VAL_INT) top.intVal = Wrap(0u - (uint32_t)top.intVal);
+                else top = Value(Wrap(0u - (uint32_t)top.AsInt()));
+                break;
+            }
+            case OP_TO_BOOL: {
+                Value& top = valueStack.back();
+                top = Value(top.IsTruthy());
+                break;
+            }
+            // Aggregates pass through: scripts hand arrays to `int a` parameters
+            case OP_TO_INT: {
+                Value& top = valueStack.back();
+                if (top.type != VAL_INT && !top.IsAggregate()) top = Value(top.AsInt());
+                break;
+            }
+            case OP_TO_FLOAT: {
+                Value& top = valueStack.back();
+                if (top.type != VAL_FLOAT && !top.IsAggregate()) top = Value(top.AsFloat());
+                break;
+            }
+
+            case OP_JUMP:
+                ip = ins.a;
+                break;
+            case OP_JUMP_IF_FALSE:
+                if (!pop().IsTruthy()) ip = ins.a;
+                break;
+            case OP_JUMP_IF_TRUE:
+                if (pop().IsTruthy()) ip = ins.a;
+                break;
+            case OP_LOOP_HEAD:
+                if (!isRunning) goto abort;
+                if (--sliceRemaining <= 0) {
+                    EndSlice();
+                    resumeIp = ip;
+                    return Value();
+                }
+                break;
+
+            case OP_CALL_BUILTIN: {
+                int argc = ins.b;
+                size_t argBase = valueStack.size() - argc;
+                sliceEffects++;
+                Value result = builtins[ins.a].fn(*this, valueStack.data() + argBase, argc);
+                valueStack.resize(argBase);
+                valueStack.push_back(std::move(result));
+                if (yieldRequested) {
+                    // The builtin slept: suspend with its result in place
+                    resumeIp = ip;
+                    return Value();
+                }
+                break;
+            }
+            case OP_CALL: {
+                if (!isRunning) goto abort;
+                if (callStack.size() >= (size_t)maxCallDepth) {
+                    RuntimeError("stack overflow", ip - 1);
+                    goto abort;
+                }
+                int argc = ins.b;
+                const FunctionDef& def = *functionTable[ins.a];
+                size_t argBase = valueStack.size() - argc;
+                PushFrame(def, ip, argBase);
+                auto& locals = callStack.back().locals;
+                for (size_t i = 0; i < def.parameters.size() && i < (size_t)argc; i++) {
+                    Value& arg = valueStack[argBase + i];
+                    const std::string& pType = def.parameters[i].first;
+                    bool byRef = !pType.empty() && pType.back() == '&';
+                    locals[i] = byRef ? std::move(arg) : Deref(std::move(arg));
+                }
+                valueStack.resize(argBase);
+                ip = def.entry;
+                break;
+            }
+            case OP_RETURN: {
+                Value ret = pop();
+                StackFrame& frame = callStack.back();
+                ip = frame.returnAddress;
+                valueStack.resize(frame.stackBase);
+                PopFrame();
+                if (callStack.size() == baseDepth) return ret;
+                valueStack.push_back(std::move(ret));
+                break;
+            }
+        }
+    }
+
+abort:
+    // Stop() was requested: drop every frame this Run() pushed
+    valueStack.resize(callStack[baseDepth].stackBase);
+    while (callStack.size() > baseDepth) PopFrame();
+    return Value();
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+// 2D vector for the simulation core, which builds without raylib. Layout
+// matches raylib's Vector2, so drawing code converts with {v.x, v.y}.
+struct Vec2 {
+    float x;
+    float y;
+};
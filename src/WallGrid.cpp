@@ -0,0 +1,343 @@
+#include "WallGrid.h"
+#include "MazeGenerator.h"
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define WALLGRID_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define WALLGRID_SSE2 1
+#endif
+
+void WallGrid::Build(const MazeGenerator& maze) {
+    width = maze.width;
+    height = maze.height;
+    walls.assign((size_t)width * height + 3, 0);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            const Cell* cell = maze.GetCell(x, y);
+            walls[y * width + x] = (cell->wallNorth ? WALL_NORTH : 0) | (cell->wallSouth ? WALL_SOUTH : 0) |
+                                   (cell->wallEast ? WALL_EAST : 0) | (cell->wallWest ? WALL_WEST : 0);
+        }
+    }
+    reach.assign((size_t)width * height, Reach());
+    for (int y = 0; y < height; y++) ScanRow(y);
+    for (int x = 0; x < width; x++) ScanColumn(x);
+}
+
+void WallGrid::SetWall(int x, int y, uint8_t side, bool present) {
+    if (x < 0 || x >= width || y < 0 || y >= height) return;
+    int nx = x, ny = y;
+    uint8_t opposite;
+    switch (side) {
+        case WALL_NORTH: ny--; opposite = WALL_SOUTH; break;
+        case WALL_SOUTH: ny++; opposite = WALL_NORTH; break;
+        case WALL_EAST: nx++; opposite = WALL_WEST; break;
+        case WALL_WEST: nx--; opposite = WALL_EAST; break;
+        default: return;
+    }
+    auto set = [&](int cx, int cy, uint8_t bit) {
+        uint8_t& cell = walls[cy * width + cx];
+        cell = present ? cell | bit : cell & ~bit;
+    };
+    set(x, y, side);
+    if (nx >= 0 && nx < width && ny >= 0 && ny < height) set(nx, ny, opposite);
+    // A wall only bounds the reach of the row or column running through it
+    if (side == WALL_EAST || side == WALL_WEST) ScanRow(y);
+    else ScanColumn(x);
+}
+
+// One more open cell, unless already past counting
+static uint16_t Extend(uint16_t reach) {
+    return reach == WallGrid::kReachUnknown ? reach : (uint16_t)(reach + 1);
+}
+
+void WallGrid::ScanRow(int y) {
+    Reach* row = &reach[y * width];
+    const uint8_t* cells = &walls[y * width];
+    for (int x = 0; x < width; x++) {
+        row[x].west = x == 0 || (cells[x] & WALL_WEST) ? 0 : Extend(row[x - 1].west);
+    }
+    for (int x = width - 1; x >= 0; x--) {
+        row[x].east = x == width - 1 || (cells[x] & WALL_EAST) ? 0 : Extend(row[x + 1].east);
+    }
+}
+
+void WallGrid::ScanColumn(int x) {
+    for (int y = 0; y < height; y++) {
+        int i = y * width + x;
+        reach[i].north = y == 0 || (walls[i] & WALL_NORTH) ? 0 : Extend(reach[i - width].north);
+    }
+    for (int y = height - 1; y >= 0; y--) {
+        int i = y * width + x;
+        reach[i].south = y == height - 1 || (walls[i] & WALL_SOUTH) ? 0 : Extend(reach[i + width].south);
+    }
+}
+
+float WallGrid::CastRay(Vec2 start, Vec2 dir, float range) const {
+    if (!(start.x >= 0.0f && start.y >= 0.0f)) return 0.0f; // Then truncating is flooring
+    int cx = (int)start.x;
+    int cy = (int)start.y;
+    if (cx >= width || cy >= height) return 0.0f;
+
+    // Along an axis the reach table gives the blocking boundary directly
+    bool onX = fabsf(dir.y) < kAxisEpsilon && fabsf(dir.x) >= kAxisEpsilon;
+    bool onY = fabsf(dir.x) < kAxisEpsilon && fabsf(dir.y) >= kAxisEpsilon;
+    if (onX || onY) {
+        const Reach& cellReach = reach[cy * width + cx];
+        uint16_t open = onX ? (dir.x > 0.0f ? cellReach.east : cellReach.west)
+                            : (dir.y > 0.0f ? cellReach.south : cellReach.north);
+        if (open != kReachUnknown) {
+            float to = onX ? (dir.x > 0.0f ? (float)(cx + 1) - start.x : start.x - (float)cx)
+                           : (dir.y > 0.0f ? (float)(cy + 1) - start.y : start.y - (float)cy);
+            float dist = to + (float)open;
+            return dist >= range ? range : dist;
+        }
+    }
+    return Trace(start, dir, range, cx, cy);
+}
+
+float WallGrid::TraceRay(Vec2 start, Vec2 dir, float range) const {
+    if (!(start.x >= 0.0f && start.y >= 0.0f)) return 0.0f;
+    int cx = (int)start.x;
+    int cy = (int)start.y;
+    if (cx >= width || cy >= height) return 0.0f;
+    return Trace(start, dir, range, cx, cy);
+}
+
+float WallGrid::Trace(Vec2 start, Vec2 dir, float range, int cx, int cy) const {
+    int index = cy * width + cx;
+
+    // Ray length per cell crossed along each axis, and to the first boundary
+    int stepX = dir.x > 0.0f ? 1 : -1;
+    int stepY = dir.y > 0.0f ? 1 : -1;
+    uint8_t wallX = stepX > 0 ? WALL_EAST : WALL_WEST;
+    uint8_t wallY = stepY > 0 ? WALL_SOUTH : WALL_NORTH;
+    float deltaX = dir.x != 0.0f ? fabsf(1.0f / dir.x) : INFINITY;
+    float deltaY = dir.y != 0.0f ? fabsf(1.0f / dir.y) : INFINITY;
+    float nextX = dir.x == 0.0f ? INFINITY : (stepX > 0 ? (float)(cx + 1) - start.x : start.x - (float)cx) * deltaX;
+    float nextY = dir.y == 0.0f ? INFINITY : (stepY > 0 ? (float)(cy + 1) - start.y : start.y - (float)cy) * deltaY;
+
+    for (;;) {
+        bool alongX = nextX < nextY;
+        float dist = alongX ? nextX : nextY;
+        if (dist >= range) return range;
+        if (walls[index] & (alongX ? wallX : wallY)) return dist;
+        if (alongX) {
+            cx += stepX;
+            index += stepX;
+            nextX += deltaX;
+        } else {
+            cy += stepY;
+            index += stepY * width;
+            nextY += deltaY;
+        }
+        if (cx < 0 || cx >= width || cy < 0 || cy >= height) return dist;
+    }
+}
+
+// The batch kernels below are CastRay() with one ray per lane: lanes that
+// finish keep stepping with their result frozen (and look up cell 0) until
+// the whole group is done. Every ray starts in the same cell, so its reach
+// comes in as four scalars.
+
+struct BatchOrigin {
+    Vec2 start;
+    int cx, cy;
+    int north, south, east, west; // Reach of the start cell
+};
+
+#if WALLGRID_AVX2
+
+static void CastRays8(const uint8_t* walls, int width, int height, const BatchOrigin& origin,
+                      const float* dirX, const float* dirY, float range, float* distances) {
+    const int cx0 = origin.cx, cy0 = origin.cy;
+    const Vec2 start = origin.start;
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 inf = _mm256_set1_ps(INFINITY);
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    const __m256 rangeV = _mm256_set1_ps(range);
+    const __m256i zeroI = _mm256_setzero_si256();
+    const __m256i byteMask = _mm256_set1_epi32(0xff);
+    const __m256i maxX = _mm256_set1_epi32(width - 1);
+    const __m256i maxY = _mm256_set1_epi32(height - 1);
+
+    __m256 dx = _mm256_loadu_ps(dirX);
+    __m256 dy = _mm256_loadu_ps(dirY);
+    __m256 posX = _mm256_cmp_ps(dx, zero, _CMP_GT_OQ);
+    __m256 posY = _mm256_cmp_ps(dy, zero, _CMP_GT_OQ);
+    __m256i posXi = _mm256_castps_si256(posX);
+    __m256i posYi = _mm256_castps_si256(posY);
+    __m256i stepX = _mm256_blendv_epi8(_mm256_set1_epi32(-1), _mm256_set1_epi32(1), posXi);
+    __m256i stepY = _mm256_blendv_epi8(_mm256_set1_epi32(-1), _mm256_set1_epi32(1), posYi);
+    __m256i rowStep = _mm256_blendv_epi8(_mm256_set1_epi32(-width), _mm256_set1_epi32(width), posYi);
+    __m256i wallX = _mm256_blendv_epi8(_mm256_set1_epi32(WallGrid::WALL_WEST), _mm256_set1_epi32(WallGrid::WALL_EAST), posXi);
+    __m256i wallY = _mm256_blendv_epi8(_mm256_set1_epi32(WallGrid::WALL_NORTH), _mm256_set1_epi32(WallGrid::WALL_SOUTH), posYi);
+    __m256 deltaX = _mm256_and_ps(_mm256_div_ps(_mm256_set1_ps(1.0f), dx), absMask);
+    __m256 deltaY = _mm256_and_ps(_mm256_div_ps(_mm256_set1_ps(1.0f), dy), absMask);
+    __m256 toX = _mm256_blendv_ps(_mm256_set1_ps(start.x - (float)cx0), _mm256_set1_ps((float)(cx0 + 1) - start.x), posX);
+    __m256 toY = _mm256_blendv_ps(_mm256_set1_ps(start.y - (float)cy0), _mm256_set1_ps((float)(cy0 + 1) - start.y), posY);
+    __m256 nextX = _mm256_blendv_ps(_mm256_mul_ps(toX, deltaX), inf, _mm256_cmp_ps(dx, zero, _CMP_EQ_OQ));
+    __m256 nextY = _mm256_blendv_ps(_mm256_mul_ps(toY, deltaY), inf, _mm256_cmp_ps(dy, zero, _CMP_EQ_OQ));
+
+    // Rays along an axis are answered from the reach and never traced
+    const __m256 eps = _mm256_set1_ps(WallGrid::kAxisEpsilon);
+    __m256 absX = _mm256_and_ps(dx, absMask);
+    __m256 absY = _mm256_and_ps(dy, absMask);
+    __m256i openX = _mm256_blendv_epi8(_mm256_set1_epi32(origin.west), _mm256_set1_epi32(origin.east), posXi);
+    __m256i openY = _mm256_blendv_epi8(_mm256_set1_epi32(origin.north), _mm256_set1_epi32(origin.south), posYi);
+    __m256i unknown = _mm256_set1_epi32(WallGrid::kReachUnknown);
+    __m256 useX = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(absY, eps, _CMP_LT_OQ), _mm256_cmp_ps(absX, eps, _CMP_GE_OQ)),
+                                _mm256_castsi256_ps(_mm256_xor_si256(_mm256_cmpeq_epi32(openX, unknown), _mm256_set1_epi32(-1))));
+    __m256 useY = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(absX, eps, _CMP_LT_OQ), _mm256_cmp_ps(absY, eps, _CMP_GE_OQ)),
+                                _mm256_castsi256_ps(_mm256_xor_si256(_mm256_cmpeq_epi32(openY, unknown), _mm256_set1_epi32(-1))));
+    __m256 axisDist = _mm256_blendv_ps(_mm256_add_ps(toY, _mm256_cvtepi32_ps(openY)),
+                                       _mm256_add_ps(toX, _mm256_cvtepi32_ps(openX)), useX);
+    axisDist = _mm256_blendv_ps(axisDist, rangeV, _mm256_cmp_ps(axisDist, rangeV, _CMP_GE_OQ));
+    __m256 useTable = _mm256_or_ps(useX, useY);
+
+    __m256i cx = _mm256_set1_epi32(cx0);
+    __m256i cy = _mm256_set1_epi32(cy0);
+    __m256i active = _mm256_xor_si256(_mm256_castps_si256(useTable), _mm256_set1_epi32(-1));
+    __m256i index = _mm256_and_si256(_mm256_set1_epi32(cy0 * width + cx0), active);
+    __m256 result = _mm256_blendv_ps(rangeV, axisDist, useTable);
+
+    while (!_mm256_testz_si256(active, active)) {
+        __m256 alongX = _mm256_cmp_ps(nextX, nextY, _CMP_LT_OQ);
+        __m256i alongXi = _mm256_castps_si256(alongX);
+        __m256 dist = _mm256_blendv_ps(nextY, nextX, alongX);
+        __m256 beyond = _mm256_cmp_ps(dist, rangeV, _CMP_GE_OQ);
+        __m256i cell = _mm256_and_si256(_mm256_i32gather_epi32((const int*)walls, index, 1), byteMask);
+        __m256i wall = _mm256_blendv_epi8(wallY, wallX, alongXi);
+        __m256i open = _mm256_cmpeq_epi32(_mm256_and_si256(cell, wall), zeroI);
+
+        cx = _mm256_add_epi32(cx, _mm256_and_si256(alongXi, stepX));
+        cy = _mm256_add_epi32(cy, _mm256_andnot_si256(alongXi, stepY));
+        index = _mm256_add_epi32(index, _mm256_blendv_epi8(rowStep, stepX, alongXi));
+        nextX = _mm256_add_ps(nextX, _mm256_and_ps(alongX, deltaX));
+        nextY = _mm256_add_ps(nextY, _mm256_andnot_ps(alongX, deltaY));
+        __m256i outside = _mm256_or_si256(_mm256_or_si256(_mm256_cmpgt_epi32(zeroI, cx), _mm256_cmpgt_epi32(cx, maxX)),
+                                          _mm256_or_si256(_mm256_cmpgt_epi32(zeroI, cy), _mm256_cmpgt_epi32(cy, maxY)));
+
+        __m256i stop = _mm256_or_si256(_mm256_castps_si256(beyond), _mm256_or_si256(outside, _mm256_xor_si256(open, _mm256_set1_epi32(-1))));
+        __m256i done = _mm256_and_si256(stop, active);
+        result = _mm256_blendv_ps(result, _mm256_blendv_ps(dist, rangeV, beyond), _mm256_castsi256_ps(done));
+        active = _mm256_andnot_si256(done, active);
+        index = _mm256_and_si256(index, active);
+    }
+    _mm256_storeu_ps(distances, result);
+}
+
+#elif WALLGRID_SSE2
+
+// SSE2 has no blend: picks `a` where `mask` is set
+static inline __m128 Select(__m128 mask, __m128 a, __m128 b) {
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+static inline __m128i Select(__m128i mask, __m128i a, __m128i b) {
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+static void CastRays4(const uint8_t* walls, int width, int height, const BatchOrigin& origin,
+                      const float* dirX, const float* dirY, float range, float* distances) {
+    const int cx0 = origin.cx, cy0 = origin.cy;
+    const Vec2 start = origin.start;
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 inf = _mm_set1_ps(INFINITY);
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    const __m128 rangeV = _mm_set1_ps(range);
+    const __m128i zeroI = _mm_setzero_si128();
+    const __m128i maxX = _mm_set1_epi32(width - 1);
+    const __m128i maxY = _mm_set1_epi32(height - 1);
+
+    __m128 dx = _mm_loadu_ps(dirX);
+    __m128 dy = _mm_loadu_ps(dirY);
+    __m128 posX = _mm_cmpgt_ps(dx, zero);
+    __m128 posY = _mm_cmpgt_ps(dy, zero);
+    __m128i posXi = _mm_castps_si128(posX);
+    __m128i posYi = _mm_castps_si128(posY);
+    __m128i stepX = Select(posXi, _mm_set1_epi32(1), _mm_set1_epi32(-1));
+    __m128i stepY = Select(posYi, _mm_set1_epi32(1), _mm_set1_epi32(-1));
+    __m128i rowStep = Select(posYi, _mm_set1_epi32(width), _mm_set1_epi32(-width));
+    __m128i wallX = Select(posXi, _mm_set1_epi32(WallGrid::WALL_EAST), _mm_set1_epi32(WallGrid::WALL_WEST));
+    __m128i wallY = Select(posYi, _mm_set1_epi32(WallGrid::WALL_SOUTH), _mm_set1_epi32(WallGrid::WALL_NORTH));
+    __m128 deltaX = _mm_and_ps(_mm_div_ps(_mm_set1_ps(1.0f), dx), absMask);
+    __m128 deltaY = _mm_and_ps(_mm_div_ps(_mm_set1_ps(1.0f), dy), absMask);
+    __m128 toX = Select(posX, _mm_set1_ps((float)(cx0 + 1) - start.x), _mm_set1_ps(start.x - (float)cx0));
+    __m128 toY = Select(posY, _mm_set1_ps((float)(cy0 + 1) - start.y), _mm_set1_ps(start.y - (float)cy0));
+    __m128 nextX = Select(_mm_cmpeq_ps(dx, zero), inf, _mm_mul_ps(toX, deltaX));
+    __m128 nextY = Select(_mm_cmpeq_ps(dy, zero), inf, _mm_mul_ps(toY, deltaY));
+
+    // Rays along an axis are answered from the reach and never traced
+    const __m128 eps = _mm_set1_ps(WallGrid::kAxisEpsilon);
+    __m128 absX = _mm_and_ps(dx, absMask);
+    __m128 absY = _mm_and_ps(dy, absMask);
+    __m128i openX = Select(posXi, _mm_set1_epi32(origin.east), _mm_set1_epi32(origin.west));
+    __m128i openY = Select(posYi, _mm_set1_epi32(origin.south), _mm_set1_epi32(origin.north));
+    __m128i unknown = _mm_set1_epi32(WallGrid::kReachUnknown);
+    __m128 useX = _mm_and_ps(_mm_and_ps(_mm_cmplt_ps(absY, eps), _mm_cmpge_ps(absX, eps)),
+                             _mm_castsi128_ps(_mm_xor_si128(_mm_cmpeq_epi32(openX, unknown), _mm_set1_epi32(-1))));
+    __m128 useY = _mm_and_ps(_mm_and_ps(_mm_cmplt_ps(absX, eps), _mm_cmpge_ps(absY, eps)),
+                             _mm_castsi128_ps(_mm_xor_si128(_mm_cmpeq_epi32(openY, unknown), _mm_set1_epi32(-1))));
+    __m128 axisDist = Select(useX, _mm_add_ps(toX, _mm_cvtepi32_ps(openX)), _mm_add_ps(toY, _mm_cvtepi32_ps(openY)));
+    axisDist = Select(_mm_cmpge_ps(axisDist, rangeV), rangeV, axisDist);
+    __m128 useTable = _mm_or_ps(useX, useY);
+
+    __m128i cx = _mm_set1_epi32(cx0);
+    __m128i cy = _mm_set1_epi32(cy0);
+    __m128i active = _mm_xor_si128(_mm_castps_si128(useTable), _mm_set1_epi32(-1));
+    __m128i index = _mm_and_si128(_mm_set1_epi32(cy0 * width + cx0), active);
+    __m128 result = Select(useTable, axisDist, rangeV);
+
+    while (_mm_movemask_epi8(active)) {
+        __m128 alongX = _mm_cmplt_ps(nextX, nextY);
+        __m128i alongXi = _mm_castps_si128(alongX);
+        __m128 dist = Select(alongX, nextX, nextY);
+        __m128 beyond = _mm_cmpge_ps(dist, rangeV);
+        alignas(16) int lanes[4];
+        _mm_store_si128((__m128i*)lanes, index);
+        __m128i cell = _mm_setr_epi32(walls[lanes[0]], walls[lanes[1]], walls[lanes[2]], walls[lanes[3]]);
+        __m128i wall = Select(alongXi, wallX, wallY);
+        __m128i open = _mm_cmpeq_epi32(_mm_and_si128(cell, wall), zeroI);
+
+        cx = _mm_add_epi32(cx, _mm_and_si128(alongXi, stepX));
+        cy = _mm_add_epi32(cy, _mm_andnot_si128(alongXi, stepY));
+        index = _mm_add_epi32(index, Select(alongXi, stepX, rowStep));
+        nextX = _mm_add_ps(nextX, _mm_and_ps(alongX, deltaX));
+        nextY = _mm_add_ps(nextY, _mm_andnot_ps(alongX, deltaY));
+        __m128i outside = _mm_or_si128(_mm_or_si128(_mm_cmplt_epi32(cx, zeroI), _mm_cmpgt_epi32(cx, maxX)),
+                                       _mm_or_si128(_mm_cmplt_epi32(cy, zeroI), _mm_cmpgt_epi32(cy, maxY)));
+
+        __m128i stop = _mm_or_si128(_mm_castps_si128(beyond), _mm_or_si128(outside, _mm_xor_si128(open, _mm_set1_epi32(-1))));
+        __m128i done = _mm_and_si128(stop, active);
+        result = Select(_mm_castsi128_ps(done), Select(beyond, rangeV, dist), result);
+        active = _mm_andnot_si128(done, active);
+        index = _mm_and_si128(index, active);
+    }
+    _mm_storeu_ps(distances, result);
+}
+
+#endif
+
+void WallGrid::CastRays(Vec2 start, const float* dirX, const float* dirY, int count, float range, float* distances) const {
+    int first = 0;
+    int cx = (int)start.x;
+    int cy = (int)start.y;
+    if (start.x >= 0.0f && start.y >= 0.0f && cx < width && cy < height) {
+        const Reach& cellReach = reach[cy * width + cx];
+        BatchOrigin origin = { start, cx, cy, cellReach.north, cellReach.south, cellReach.east, cellReach.west };
+#if WALLGRID_AVX2
+        for (; first + 8 <= count; first += 8) {
+            CastRays8(walls.data(), width, height, origin, dirX + first, dirY + first, range, distances + first);
+        }
+#elif WALLGRID_SSE2
+        for (; first + 4 <= count; first += 4) {
+            CastRays4(walls.data(), width, height, origin, dirX + first, dirY + first, range, distances + first);
+        }
+#else
+        (void)origin;
+#endif
+    }
+    for (int i = first; i < count; i++) distances[i] = CastRay(start, { dirX[i], dirY[i] }, range);
+}
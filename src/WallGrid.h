@@ -0,0 +1,55 @@
+#pragma once
+#include "Vec2.h"
+#include <cstdint>
+#include <vector>
+
+class MazeGenerator;
+
+// A maze's walls packed one byte per cell for ray casting. Rays walk cell
+// boundaries in order (Amanatides & Woo) and stop at the first one with a
+// wall on it or the edge of the maze, returning the exact distance in cells.
+//
+// CastRays() traces a batch of rays from one point, several at a time in
+// SIMD lanes: 8 with AVX2, 4 with SSE2, one by one elsewhere. Every path
+// does the same float operations, so results do not depend on the CPU.
+//
+// Rays along a grid axis, within kAxisEpsilon, are answered in O(1) from a
+// table of how many open cells lie beyond each cell in each direction. The
+// table is built with one scan per row and column, and SetWall() rescans
+// only the row or column a wall change affects.
+class WallGrid {
+public:
+    enum : uint8_t { WALL_NORTH = 1, WALL_SOUTH = 2, WALL_EAST = 4, WALL_WEST = 8 };
+    // Largest off-axis direction component still treated as on the axis
+    static constexpr float kAxisEpsilon = 1e-5f;
+    // Reach too long to count in the table; such rays are traced instead
+    static const uint16_t kReachUnknown = 0xffff;
+
+    void Build(const MazeGenerator& maze);
+    // Adds or removes one wall (a WALL_* side of cell x, y) on both cells it separates
+    void SetWall(int x, int y, uint8_t side, bool present);
+
+    // `dir` is a unit vector; walls past `range` read as `range`
+    float CastRay(Vec2 start, Vec2 dir, float range) const;
+    // CastRay() without the reach table: always walks the boundaries
+    float TraceRay(Vec2 start, Vec2 dir, float range) const;
+    void CastRays(Vec2 start, const float* dirX, const float* dirY, int count, float range, float* distances) const;
+
+    int Width() const { return width; }
+    int Height() const { return height; }
+
+private:
+    int width = 0;
+    int height = 0;
+    std::vector<uint8_t> walls; // Row-major, plus padding for 32-bit gathers
+
+    // Open cells beyond a cell before a wall or the maze edge, per direction
+    struct Reach {
+        uint16_t north, south, east, west;
+    };
+    std::vector<Reach> reach; // Row-major
+
+    void ScanRow(int y);
+    void ScanColumn(int x);
+    float Trace(Vec2 start, Vec2 dir, float range, int cx, int cy) const; // From inside cell cx, cy
+};
@@ -5,6 +5,7 @@
 #include "MazeGenerator.h"
 #include "IDE.h"
 #include "Simulation.h"
+#include "ProgramCache.h"
 
 enum AppState {
     STATE_DESIGNER,
@@ -28,7 +29,10 @@ int main() {
     MazeGenerator generator;
     UI ui(generator);
     IDE ide;
+    // Kept on disk, so reopening the app with the same script skips parsing it
+    ProgramCache programCache(".mazerobo-cache");
     Simulation simulation;
+    simulation.sharedProgramCache = &programCache;
 
     // Main game loop
     while (!WindowShouldClose()) {
@@ -48,7 +52,7 @@ int main() {
                 }
                 break;
             case STATE_SIMULATION:
-                simulation.Update();
+                simulation.Update(GetFrameTime());
                 break;
         }
         
@@ -69,8 +73,14 @@ int main() {
                     ide.Draw(generator, simulation);
                     
                     // Button to start simulation (Overlay)
-                    ImGui::SetNextWindowPos({(float)screenWidth - 220, (float)screenHeight - 60});
-                    ImGui::Begin("SimControl", nullptr, ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoBackground);
+                    ImGui::SetNextWindowPos({(float)screenWidth - 430, (float)screenHeight - 60});
+                    ImGui::Begin("SimControl", nullptr, ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoBackground | ImGuiWindowFlags_AlwaysAutoResize);
+                    // Keeps the robot and the script's state; edits apply from the next loop()
+                    if (ImGui::Button("Apply to Running", {200, 40})) {
+                        simulation.Reload(generator, ide.code);
+                        currentState = STATE_SIMULATION;
+                    }
+                    ImGui::SameLine();
                     if (ImGui::Button("Start Simulation", {200, 40})) {
                         simulation.Init(generator, ide.code);
                         currentState = STATE_SIMULATION;
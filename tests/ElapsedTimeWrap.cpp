@@ -0,0 +1,74 @@
+// Checks that `micros() - start` and `millis() - start` give the elapsed
+// time across the points where the 32-bit readings wrap: where they turn
+// negative (2^31) and where they roll over to 0 (2^32). Both are ints to
+// the compiler, so the subtractions run as wrapping int instructions.
+//
+// Each case starts the clock 300 ms before a wrap point and runs a script
+// that measures a delay(600) in lockstep. Exits 1 on any mismatch.
+#include "Interpreter.h"
+#include "SimClock.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+static const char* kScript =
+    "void setup() {\n"
+    "  int start = micros();\n"
+    "  int startMs = millis();\n"
+    "  delay(600);\n"
+    "  int elapsed = micros() - start;\n"
+    "  int elapsedMs = millis() - startMs;\n"
+    "  digitalWrite(20, start);\n"
+    "  digitalWrite(21, elapsed);\n"
+    "  digitalWrite(22, 0);\n"
+    "  if (elapsed > 500000) digitalWrite(22, 1);\n"
+    "  digitalWrite(23, startMs);\n"
+    "  digitalWrite(24, elapsedMs);\n"
+    "  digitalWrite(25, 0);\n"
+    "  if (elapsedMs > 500) digitalWrite(25, 1);\n"
+    "}\n"
+    "void loop() {\n"
+    "  delay(1000);\n"
+    "}\n";
+
+static bool Check(const char* name, int64_t startMicros) {
+    SimClock clock;
+    clock.SetMode(SimClock::SIMULATED);
+    Interpreter interpreter;
+    interpreter.SetClock(&clock);
+    interpreter.SetLockstep(true);
+    interpreter.Load(kScript);
+    interpreter.Start(); // Resets the clock; nothing runs until RunLockstep()
+    clock.AdvanceTo(startMicros);
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    for (;;) {
+        int64_t wake = interpreter.RunLockstep(deadline);
+        if (wake == INT64_MAX || wake > startMicros + 700000 || std::chrono::steady_clock::now() >= deadline) break;
+        clock.AdvanceTo(wake);
+    }
+    int start = interpreter.GetPinValue(20);
+    int elapsed = interpreter.GetPinValue(21);
+    int startMs = interpreter.GetPinValue(23);
+    int elapsedMs = interpreter.GetPinValue(24);
+    bool ok = start == (int)(uint32_t)startMicros && elapsed == 600000 && interpreter.GetPinValue(22) == 1 &&
+              startMs == (int)(uint32_t)(startMicros / 1000) && elapsedMs == 600 && interpreter.GetPinValue(25) == 1;
+    std::string error = interpreter.GetRuntimeError();
+    interpreter.Stop();
+
+    printf("%s %s: micros %d + %d, millis %d + %d%s%s\n", ok ? "ok  " : "FAIL", name, start, elapsed, startMs,
+           elapsedMs, error.empty() ? "" : ", script stopped: ", error.c_str());
+    return ok;
+}
+
+int main() {
+    const int64_t k2to31 = INT64_C(1) << 31;
+    const int64_t k2to32 = INT64_C(1) << 32;
+    bool ok = true;
+    ok &= Check("micros() turns negative", k2to31 - 300000);
+    ok &= Check("micros() rolls over", k2to32 - 300000);
+    ok &= Check("millis() turns negative", (k2to31 - 300) * 1000);
+    ok &= Check("millis() rolls over", (k2to32 - 300) * 1000);
+    return ok ? 0 : 1;
+}
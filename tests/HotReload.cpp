@@ -0,0 +1,146 @@
+// Checks Interpreter::Reload() on a running script. The first version sets
+// its globals in setup(); the second, swapped in between two loop() calls,
+// reports them on pins. A global whose name, type and shape are unchanged
+// must keep its value; one whose type, array size or struct members changed
+// must get the new initializer; setup() must not run again. A third version
+// brings back a global the second one removed, which must start afresh.
+//
+// Runs in lockstep on a simulated clock. Exits 1 on any mismatch.
+#include "Interpreter.h"
+#include "SimClock.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+static const char* kFirst =
+    "struct Pose {\n"
+    "  int x;\n"
+    "  int y;\n"
+    "};\n"
+    "struct Gains {\n"
+    "  int p;\n"
+    "};\n"
+    "int counter = 0;\n"
+    "float speed = 1.5;\n"
+    "int path[4];\n"
+    "Pose pose;\n"
+    "int retyped = 3;\n"
+    "int resized[2];\n"
+    "Gains gains;\n"
+    "int removed = 8;\n"
+    "void setup() {\n"
+    "  speed = 2.5;\n"
+    "  path[2] = 5;\n"
+    "  pose.x = 3;\n"
+    "  pose.y = 4;\n"
+    "  retyped = 4;\n"
+    "  resized[1] = 9;\n"
+    "  gains.p = 7;\n"
+    "  removed = 80;\n"
+    "}\n"
+    "void loop() {\n"
+    "  counter++;\n"
+    "  digitalWrite(20, counter);\n"
+    "  delay(1000);\n"
+    "}\n";
+
+// counter, speed, path and pose are unchanged; retyped, resized and gains
+// are not; removed is gone
+static const char* kSecond =
+    "struct Pose {\n"
+    "  int x;\n"
+    "  int y;\n"
+    "};\n"
+    "struct Gains {\n"
+    "  int p;\n"
+    "  int i;\n"
+    "};\n"
+    "int counter = 100;\n"
+    "float speed = 9.5;\n"
+    "int path[4];\n"
+    "Pose pose;\n"
+    "float retyped = 1.5;\n"
+    "int resized[3];\n"
+    "Gains gains;\n"
+    "int added = 42;\n"
+    "void setup() {\n"
+    "  digitalWrite(31, 1);\n"
+    "}\n"
+    "void loop() {\n"
+    "  digitalWrite(21, counter);\n"
+    "  digitalWrite(22, (int)(speed * 10));\n"
+    "  digitalWrite(23, path[2]);\n"
+    "  digitalWrite(24, pose.x * 10 + pose.y);\n"
+    "  digitalWrite(25, (int)(retyped * 10));\n"
+    "  digitalWrite(26, resized[1]);\n"
+    "  digitalWrite(27, gains.p);\n"
+    "  digitalWrite(28, added);\n"
+    "  delay(1000);\n"
+    "}\n";
+
+static const char* kThird =
+    "int counter = 0;\n"
+    "int removed = 1;\n"
+    "void loop() {\n"
+    "  digitalWrite(29, removed);\n"
+    "  digitalWrite(30, counter);\n"
+    "  delay(1000);\n"
+    "}\n";
+
+// Steps the script in lockstep until the simulated clock passes `untilMicros`
+static void RunUntil(Interpreter& interpreter, SimClock& clock, int64_t untilMicros) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    for (;;) {
+        int64_t wake = interpreter.RunLockstep(deadline);
+        if (wake == INT64_MAX || wake > untilMicros || std::chrono::steady_clock::now() >= deadline) break;
+        clock.AdvanceTo(wake);
+    }
+    if (clock.NowMicros() < untilMicros) clock.AdvanceTo(untilMicros);
+}
+
+static bool Check(Interpreter& interpreter, const char* name, int pin, int expected) {
+    int value = interpreter.GetPinValue(pin);
+    bool ok = value == expected;
+    printf("%s %s: %d, expected %d\n", ok ? "ok  " : "FAIL", name, value, expected);
+    return ok;
+}
+
+int main() {
+    SimClock clock;
+    clock.SetMode(SimClock::SIMULATED);
+    Interpreter interpreter;
+    interpreter.SetClock(&clock);
+    interpreter.SetLockstep(true);
+    interpreter.Load(kFirst);
+    interpreter.Start();
+
+    // loop() runs at 0, 1 and 2 s; the reload lands when the 2 s call returns
+    RunUntil(interpreter, clock, 2500000);
+    bool ok = true;
+    ok &= Check(interpreter, "first version ran", 20, 3);
+    interpreter.Reload(kSecond);
+    RunUntil(interpreter, clock, 4500000);
+    ok &= Check(interpreter, "unchanged int kept", 21, 3);
+    ok &= Check(interpreter, "unchanged float kept", 22, 25);
+    ok &= Check(interpreter, "unchanged array kept", 23, 5);
+    ok &= Check(interpreter, "unchanged struct kept", 24, 34);
+    ok &= Check(interpreter, "int turned float re-initialised", 25, 15);
+    ok &= Check(interpreter, "resized array re-initialised", 26, 0);
+    ok &= Check(interpreter, "struct with a new member re-initialised", 27, 0);
+    ok &= Check(interpreter, "new global initialised", 28, 42);
+    ok &= Check(interpreter, "setup() not run again", 31, 0);
+
+    interpreter.Reload(kThird);
+    RunUntil(interpreter, clock, 6500000);
+    ok &= Check(interpreter, "removed global dropped", 29, 1);
+    ok &= Check(interpreter, "kept global survives a second reload", 30, 3);
+
+    std::string error = interpreter.GetRuntimeError();
+    interpreter.Stop();
+    if (!error.empty()) {
+        printf("FAIL script stopped: %s\n", error.c_str());
+        ok = false;
+    }
+    return ok ? 0 : 1;
+}
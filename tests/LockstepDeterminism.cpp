@@ -0,0 +1,143 @@
+// Runs a script twice against the same generated maze, set up the way
+// mazerobo-run sets it up (lockstep, simulated time, a program cache), and
+// checks that both runs end with identical Stats and simulated time: in
+// lockstep the result may depend only on the seed, the size and the script.
+//
+//   lockstep-determinism examples/flood_fill.cpp
+//
+// The given script (flood_fill.cpp, which only computes) and a wall
+// follower, which drives and reads its sensors, are each run twice. Then a
+// robot driving straight out of one-column mazes must reach the exit at the
+// exact microsecond recorded here: two cells a second, stamped at the end of
+// the 1 ms physics step that got it there. The 1x2 run lands one step after
+// the 250 ms its speed gives, where the summed float steps fall just short of
+// the cell edge; any change to that arithmetic shows up as a new goal time.
+//
+// Exits 1 on any difference.
+#include "MazeGenerator.h"
+#include "ProgramCache.h"
+#include "Simulation.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+static const char* kWallFollower =
+    "int cm(int echo) {\n"
+    "  return pulseIn(echo, 1, 30000) * 0.034 / 2;\n"
+    "}\n"
+    "void loop() {\n"
+    "  if (cm(7) > 30) {\n"
+    "    right();\n"
+    "    forward();\n"
+    "    delay(400);\n"
+    "    stop();\n"
+    "  } else if (cm(3) > 30) {\n"
+    "    forward();\n"
+    "    delay(400);\n"
+    "    stop();\n"
+    "  } else {\n"
+    "    left();\n"
+    "  }\n"
+    "}\n";
+
+struct Result {
+    Simulation::Stats stats;
+    int64_t simMicros;
+    std::string error;
+};
+
+// mazerobo-run's main loop: 100 ms of simulated time at a time until the
+// goal, the script stopping or the time limit
+static Result Run(const std::string& script, unsigned seed, int width, int height, double maxSimTime) {
+    MazeGenerator maze;
+    maze.Generate(width, height, seed);
+    ProgramCache programCache;
+    Simulation simulation;
+    simulation.sharedProgramCache = &programCache;
+    simulation.useLockstep = true;
+    simulation.useSimulatedTime = true;
+    simulation.Init(maze, script);
+
+    auto wallLimit = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+    int64_t simLimit = (int64_t)(maxSimTime * 1e6);
+    for (;;) {
+        auto now = std::chrono::steady_clock::now();
+        if (simulation.stats.reachedGoal || !simulation.IsScriptRunning() || simulation.SimTimeMicros() >= simLimit ||
+            now >= wallLimit) {
+            break;
+        }
+        int64_t until = std::min(simLimit, simulation.SimTimeMicros() + 100000);
+        simulation.RunUntil(until, std::min(wallLimit, now + std::chrono::milliseconds(50)));
+    }
+    return { simulation.stats, simulation.SimTimeMicros(), simulation.GetScriptError() };
+}
+
+static void Print(const char* label, const Result& r) {
+    printf("     %s: sim %lld us, distance %.9g, collisions %d, goal %s at %lld us%s%s\n", label,
+           (long long)r.simMicros, r.stats.distance, r.stats.collisions, r.stats.reachedGoal ? "reached" : "not reached",
+           (long long)r.stats.goalMicros, r.error.empty() ? "" : ", script stopped: ", r.error.c_str());
+}
+
+static bool Same(const Result& a, const Result& b) {
+    return memcmp(&a.stats.distance, &b.stats.distance, sizeof(float)) == 0 && a.stats.collisions == b.stats.collisions &&
+           a.stats.reachedGoal == b.stats.reachedGoal && a.stats.goalMicros == b.stats.goalMicros &&
+           a.simMicros == b.simMicros && a.error == b.error;
+}
+
+static const char* kStraightOut =
+    "void setup() {\n"
+    "  forward();\n"
+    "}\n"
+    "void loop() {\n"
+    "  delay(1000);\n"
+    "}\n";
+
+static bool CheckGoalTime(unsigned seed, int height, int64_t expectedMicros) {
+    Result first = Run(kStraightOut, seed, 1, height, 10.0);
+    Result second = Run(kStraightOut, seed, 1, height, 10.0);
+    bool ok = Same(first, second) && first.stats.reachedGoal && first.stats.goalMicros == expectedMicros;
+    printf("%s straight out of a 1x%d maze, seed %u: goal at %lld us, expected %lld\n", ok ? "ok  " : "FAIL", height,
+           seed, (long long)first.stats.goalMicros, (long long)expectedMicros);
+    if (!ok) {
+        Print("first", first);
+        Print("second", second);
+    }
+    return ok;
+}
+
+static bool CheckTwice(const char* name, const std::string& script, unsigned seed, int width, int height,
+                       double maxSimTime, bool mustMove) {
+    Result first = Run(script, seed, width, height, maxSimTime);
+    Result second = Run(script, seed, width, height, maxSimTime);
+    bool ok = Same(first, second) && first.error.empty() && (!mustMove || first.stats.distance > 0.0f);
+    printf("%s %s, seed %u, %dx%d\n", ok ? "ok  " : "FAIL", name, seed, width, height);
+    Print("first", first);
+    Print("second", second);
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: lockstep-determinism SCRIPT\n");
+        return 2;
+    }
+    std::ifstream file(argv[1]);
+    if (!file) {
+        fprintf(stderr, "lockstep-determinism: cannot read %s\n", argv[1]);
+        return 2;
+    }
+    std::stringstream code;
+    code << file.rdbuf();
+
+    bool ok = true;
+    ok &= CheckTwice(argv[1], code.str(), 1, 20, 20, 5.0, false);
+    ok &= CheckTwice("wall follower", kWallFollower, 3, 8, 8, 120.0, true);
+    ok &= CheckGoalTime(1, 2, 251000);
+    ok &= CheckGoalTime(1, 3, 750000);
+    ok &= CheckGoalTime(7, 5, 1750000);
+    return ok ? 0 : 1;
+}
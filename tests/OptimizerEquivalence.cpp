@@ -0,0 +1,204 @@
+// Runs scripts with the optimizer on and off and checks that both leave
+// every pin the same, and that the pins hold the values worked out by hand.
+// The scripts aim at what the optimizer rewrites: calls inlined with
+// by-reference variables as arguments, const globals shadowed by locals,
+// int and float arithmetic folded across casts, and recursive functions,
+// which must stay calls.
+//
+// Exits 1 on any mismatch.
+#include "Interpreter.h"
+#include "SimClock.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct Case {
+    const char* name;
+    const char* script;
+    std::vector<std::pair<int, int>> expected; // Pin, value
+};
+
+static const Case kCases[] = {
+    {
+        "by-reference argument to inlined functions",
+        "int history = 0;\n"
+        "pile trail;\n"
+        "int twice(int v) { return v * 2; }\n"
+        "void note(int v) { history = history * 10 + v; }\n"
+        "void keep(int v) { push(trail, v); }\n"
+        "void bumpCopy(int v) {\n"
+        "  v = v + 100;\n"
+        "  digitalWrite(23, v);\n"
+        "}\n"
+        "void work(int& r) {\n"
+        "  r = r + 1;\n"
+        "  digitalWrite(20, twice(r));\n"
+        "  note(r);\n"
+        "  keep(r);\n"
+        "  bumpCopy(r);\n"
+        "  r = r + 1;\n"
+        "}\n"
+        "void setup() {\n"
+        "  int x = 4;\n"
+        "  work(x);\n"
+        "  digitalWrite(21, x);\n"
+        "  digitalWrite(22, history);\n"
+        "  digitalWrite(24, pop(trail));\n"
+        "  work(x);\n"
+        "  digitalWrite(25, x);\n"
+        "  digitalWrite(26, history);\n"
+        "}\n"
+        "void loop() { delay(1000); }\n",
+        { { 20, 14 }, { 21, 6 }, { 22, 5 }, { 23, 107 }, { 24, 5 }, { 25, 8 }, { 26, 57 } },
+    },
+    {
+        "const shadowed by locals",
+        "const int K = 5;\n"
+        "int g = 4;\n"
+        "int shadow() {\n"
+        "  int K = 2;\n"
+        "  return K * 3;\n"
+        "}\n"
+        "void shadowNote() {\n"
+        "  int K = 2;\n"
+        "  digitalWrite(27, K * 7);\n"
+        "}\n"
+        "int param(int K) { return K * 10; }\n"
+        "int readK() { return K + 1; }\n"
+        "int useG() { return g + 1; }\n"
+        "int loopK() {\n"
+        "  int last = 0;\n"
+        "  for (int K = 0; K < 3; K++) last = K;\n"
+        "  return last;\n"
+        "}\n"
+        "void setup() {\n"
+        "  digitalWrite(20, shadow());\n"
+        "  digitalWrite(21, param(3));\n"
+        "  digitalWrite(22, readK());\n"
+        "  int g = 100;\n"
+        "  digitalWrite(23, useG());\n"
+        "  digitalWrite(24, g);\n"
+        "  digitalWrite(25, loopK());\n"
+        "  digitalWrite(26, K);\n"
+        "  shadowNote();\n"
+        "}\n"
+        "void loop() { delay(1000); }\n",
+        { { 20, 6 }, { 21, 30 }, { 22, 6 }, { 23, 5 }, { 24, 100 }, { 25, 2 }, { 26, 5 }, { 27, 14 } },
+    },
+    {
+        "int division and truncation across casts",
+        "const int A = 7;\n"
+        "const int B = 2;\n"
+        "const float H = 1.5;\n"
+        "void setup() {\n"
+        "  int a = 7;\n"
+        "  digitalWrite(20, A / B);\n"
+        "  digitalWrite(21, (int)(A / B * H * 100));\n"
+        "  digitalWrite(22, (int)((float)A / B * H * 100));\n"
+        "  digitalWrite(23, -A / B);\n"
+        "  digitalWrite(24, (int)(-2.5) + (int)2.9);\n"
+        "  digitalWrite(25, (int)((float)(A / B) * 10));\n"
+        "  digitalWrite(26, A % B * 100 + (-A) % B);\n"
+        "  digitalWrite(27, (int)(A / 2.0 * 10));\n"
+        "  digitalWrite(28, a / B + (int)(a / 4.0 * 100));\n"
+        "  digitalWrite(29, (int)(float)(int)3.99 * 10);\n"
+        "  int top = 2147483647;\n"
+        "  digitalWrite(30, top + 1);\n"
+        "  digitalWrite(31, 2147483647 + 1);\n"
+        "  digitalWrite(32, (int)(A / B / 2.0 * 100));\n"
+        "}\n"
+        "void loop() { delay(1000); }\n",
+        { { 20, 3 }, { 21, 450 }, { 22, 525 }, { 23, -3 }, { 24, 0 }, { 25, 30 }, { 26, 99 }, { 27, 35 },
+          { 28, 178 }, { 29, 30 }, { 30, INT32_MIN }, { 31, INT32_MIN }, { 32, 150 } },
+    },
+    {
+        "recursive functions stay calls",
+        "int hits = 0;\n"
+        "void countDown(int n) {\n"
+        "  if (n > 0) {\n"
+        "    hits = hits + 1;\n"
+        "    countDown(n - 1);\n"
+        "  }\n"
+        "}\n"
+        "void ping(int n) {\n"
+        "  if (n > 0) {\n"
+        "    hits = hits + 10;\n"
+        "    pong(n - 1);\n"
+        "  }\n"
+        "}\n"
+        "void pong(int n) {\n"
+        "  if (n > 0) {\n"
+        "    hits = hits + 100;\n"
+        "    ping(n - 1);\n"
+        "  }\n"
+        "}\n"
+        "int fact(int n) {\n"
+        "  if (n < 2) return 1;\n"
+        "  return n * fact(n - 1);\n"
+        "}\n"
+        "int wrap(int n) { return fact(n); }\n"
+        "void setup() {\n"
+        "  countDown(5);\n"
+        "  digitalWrite(20, hits);\n"
+        "  ping(4);\n"
+        "  digitalWrite(21, hits);\n"
+        "  digitalWrite(22, fact(10));\n"
+        "  digitalWrite(23, wrap(5));\n"
+        "}\n"
+        "void loop() { delay(1000); }\n",
+        { { 20, 5 }, { 21, 225 }, { 22, 3628800 }, { 23, 120 } },
+    },
+};
+
+// Every pin after two simulated seconds in lockstep
+static std::vector<int> Run(const char* script, bool optimize, std::string& error) {
+    SimClock clock;
+    clock.SetMode(SimClock::SIMULATED);
+    Interpreter interpreter;
+    interpreter.SetClock(&clock);
+    interpreter.SetLockstep(true);
+    interpreter.SetOptimize(optimize);
+    interpreter.Load(script);
+    interpreter.Start();
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    for (;;) {
+        int64_t wake = interpreter.RunLockstep(deadline);
+        if (wake == INT64_MAX || wake > 2000000 || std::chrono::steady_clock::now() >= deadline) break;
+        clock.AdvanceTo(wake);
+    }
+    std::vector<int> pins(PinBank::kPinCount);
+    interpreter.GetPinValues(0, PinBank::kPinCount, pins.data());
+    error = interpreter.GetRuntimeError();
+    interpreter.Stop();
+    return pins;
+}
+
+static bool Check(const Case& c) {
+    std::string errorOn, errorOff;
+    std::vector<int> on = Run(c.script, true, errorOn);
+    std::vector<int> off = Run(c.script, false, errorOff);
+    bool ok = on == off && errorOn.empty() && errorOff.empty();
+    for (int pin = 0; pin < PinBank::kPinCount; pin++) {
+        if (on[pin] != off[pin]) printf("     pin %d: optimized %d, unoptimized %d\n", pin, on[pin], off[pin]);
+    }
+    for (auto& expected : c.expected) {
+        if (on[expected.first] != expected.second) {
+            printf("     pin %d: %d, expected %d\n", expected.first, on[expected.first], expected.second);
+            ok = false;
+        }
+    }
+    if (!errorOn.empty()) printf("     optimized script stopped: %s\n", errorOn.c_str());
+    if (!errorOff.empty()) printf("     unoptimized script stopped: %s\n", errorOff.c_str());
+    printf("%s %s\n", ok ? "ok  " : "FAIL", c.name);
+    return ok;
+}
+
+int main() {
+    bool ok = true;
+    for (const Case& c : kCases) ok &= Check(c);
+    return ok ? 0 : 1;
+}
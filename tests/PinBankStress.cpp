@@ -0,0 +1,64 @@
+// Runs a script that switches the motors between forward() and backward()
+// as fast as the interpreter goes, while this thread reads the motor pins
+// the way the simulation does. Every snapshot must be a whole command: a mix
+// of the two (say IN1 from forward, IN2 from backward) is a torn read.
+//
+//   pinbank-stress [SECONDS]
+//
+// Exits 1 if any GetPinValues() snapshot was torn. Pin-by-pin reads, which
+// can tear, are counted alongside to show the test actually races.
+#include "Interpreter.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+static const char* kScript =
+    "void loop() {\n"
+    "  forward();\n"
+    "  backward();\n"
+    "}\n";
+
+// Motor pins 8-11 as forward(), backward() or stop() (before the first command) set them
+static bool WholeCommand(const int* motor) {
+    static const int kCommands[3][4] = { { 1, 0, 1, 0 }, { 0, 1, 0, 1 }, { 0, 0, 0, 0 } };
+    for (const auto& command : kCommands) {
+        if (motor[0] == command[0] && motor[1] == command[1] && motor[2] == command[2] && motor[3] == command[3]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int main(int argc, char** argv) {
+    double seconds = argc > 1 ? atof(argv[1]) : 1.0;
+
+    Interpreter interpreter;
+    interpreter.Load(kScript);
+    interpreter.Start();
+
+    long long reads = 0, torn = 0, pinByPinTorn = 0;
+    auto end = std::chrono::steady_clock::now() + std::chrono::microseconds((long long)(seconds * 1e6));
+    while (std::chrono::steady_clock::now() < end) {
+        for (int i = 0; i < 1000; i++) {
+            int motor[4];
+            interpreter.GetPinValues(8, 4, motor);
+            if (!WholeCommand(motor)) torn++;
+            for (int pin = 0; pin < 4; pin++) motor[pin] = interpreter.GetPinValue(8 + pin);
+            if (!WholeCommand(motor)) pinByPinTorn++;
+            reads++;
+        }
+    }
+    bool running = interpreter.IsRunning();
+    interpreter.Stop();
+
+    printf("%lld snapshots, %lld torn; %lld torn pin by pin\n", reads, torn, pinByPinTorn);
+    if (!running) {
+        printf("FAIL: script stopped: %s\n", interpreter.GetRuntimeError().c_str());
+        return 1;
+    }
+    if (torn > 0) {
+        printf("FAIL: torn motor reads\n");
+        return 1;
+    }
+    return 0;
+}
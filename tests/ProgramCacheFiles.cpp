@@ -0,0 +1,214 @@
+// Checks the program cache's files: a program written by one ProgramCache
+// and read back by a fresh one over the same directory runs exactly like
+// the script parsed from scratch, and a damaged file, a file for another
+// variant, or an entry for a colliding source is a miss rather than the
+// wrong program.
+//
+// Each case works in its own directory under the system temp directory,
+// removed at the end. Exits 1 on any mismatch.
+#include "Interpreter.h"
+#include "ProgramCache.h"
+#include "SimClock.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static const char* kScript =
+    "struct Point {\n"
+    "  int x;\n"
+    "  float y;\n"
+    "};\n"
+    "const int N = 8;\n"
+    "int squares[8];\n"
+    "pile trail;\n"
+    "int sum(int n) {\n"
+    "  int s = 0;\n"
+    "  for (int i = 0; i < n; i++) s = s + squares[i];\n"
+    "  return s;\n"
+    "}\n"
+    "void setup() {\n"
+    "  for (int i = 0; i < N; i++) squares[i] = i * i;\n"
+    "  Point p;\n"
+    "  p.x = 7;\n"
+    "  p.y = 2.5;\n"
+    "  push(trail, p.x);\n"
+    "  digitalWrite(20, sum(N));\n"
+    "  digitalWrite(21, p.x * 3 + pop(trail));\n"
+    "  digitalWrite(22, (int)(p.y * 4));\n"
+    "}\n"
+    "void loop() {\n"
+    "  digitalWrite(23, millis() / 1000);\n"
+    "  delay(1000);\n"
+    "}\n";
+
+static const char* kOtherScript =
+    "void setup() {\n"
+    "  digitalWrite(20, 99);\n"
+    "}\n"
+    "void loop() {\n"
+    "  delay(1000);\n"
+    "}\n";
+
+// Every pin after three simulated seconds in lockstep
+static std::vector<int> Run(const std::string& script, ProgramCache* cache) {
+    SimClock clock;
+    clock.SetMode(SimClock::SIMULATED);
+    Interpreter interpreter;
+    interpreter.SetClock(&clock);
+    interpreter.SetLockstep(true);
+    interpreter.SetProgramCache(cache);
+    interpreter.Load(script);
+    interpreter.Start();
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    for (;;) {
+        int64_t wake = interpreter.RunLockstep(deadline);
+        if (wake == INT64_MAX || wake > 3000000 || std::chrono::steady_clock::now() >= deadline) break;
+        clock.AdvanceTo(wake);
+    }
+    std::vector<int> pins(PinBank::kPinCount);
+    interpreter.GetPinValues(0, PinBank::kPinCount, pins.data());
+    interpreter.Stop();
+    return pins;
+}
+
+static bool Check(const char* name, bool ok, const char* detail = "") {
+    printf("%s %s%s\n", ok ? "ok  " : "FAIL", name, detail);
+    return ok;
+}
+
+// A fresh directory for one case
+static fs::path CaseDir(const fs::path& root, const char* name) {
+    fs::path dir = root / name;
+    fs::create_directories(dir);
+    return dir;
+}
+
+// The only cache file in `dir`
+static fs::path OnlyFile(const fs::path& dir) {
+    fs::path found;
+    for (auto& entry : fs::directory_iterator(dir)) {
+        if (entry.path().extension() == ".mrp") found = entry.path();
+    }
+    return found;
+}
+
+// Writes kScript's program into `dir` the way Interpreter::Load() does
+static void WriteProgram(const fs::path& dir, uint64_t variant, std::shared_ptr<const ParsedProgram> program) {
+    ProgramCache cache(dir.string());
+    cache.Insert(kScript, variant, program);
+}
+
+int main() {
+    fs::path root = fs::temp_directory_path() /
+                    ("mazerobo-cache-test-" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+    bool ok = true;
+
+    // The program and variant Load() would cache, taken from an interpreter
+    Interpreter parser;
+    ProgramCache memory;
+    parser.SetProgramCache(&memory);
+    parser.Load(kScript);
+    uint64_t variant = parser.FrontEndVariant();
+    std::shared_ptr<const ParsedProgram> program = memory.Find(kScript, variant);
+    ok &= Check("Load() inserts its program", program != nullptr);
+    if (!program) return 1;
+    std::vector<int> expected = Run(kScript, nullptr);
+
+    {
+        fs::path dir = CaseDir(root, "roundtrip");
+        std::vector<int> first;
+        {
+            ProgramCache writer(dir.string());
+            first = Run(kScript, &writer); // Parses and writes the file
+        }
+        ProgramCache reader(dir.string());
+        bool found = reader.Find(kScript, variant) != nullptr;
+        std::vector<int> second = Run(kScript, &reader); // Runs the program read from the file
+        char detail[96];
+        snprintf(detail, sizeof(detail), ": pins 20-23 %d %d %d %d", second[20], second[21], second[22], second[23]);
+        ok &= Check("file read by a fresh cache", found);
+        ok &= Check("read program runs like a parsed one", first == expected && second == expected, detail);
+    }
+
+    {
+        fs::path dir = CaseDir(root, "truncated");
+        WriteProgram(dir, variant, program);
+        fs::path file = OnlyFile(dir);
+        fs::resize_file(file, fs::file_size(file) / 2);
+        ProgramCache reader(dir.string());
+        ok &= Check("truncated file is a miss", reader.Find(kScript, variant) == nullptr);
+    }
+
+    {
+        fs::path dir = CaseDir(root, "flipped");
+        WriteProgram(dir, variant, program);
+        fs::path file = OnlyFile(dir);
+        std::fstream stream(file, std::ios::binary | std::ios::in | std::ios::out);
+        stream.seekg(fs::file_size(file) / 2); // Past the header: the payload holds the source
+        char byte = 0;
+        stream.read(&byte, 1);
+        byte ^= 0x10;
+        stream.seekp(fs::file_size(file) / 2);
+        stream.write(&byte, 1);
+        stream.close();
+        ProgramCache reader(dir.string());
+        ok &= Check("file with a flipped payload byte is a miss", reader.Find(kScript, variant) == nullptr);
+    }
+
+    {
+        // A file written for variant + 1, moved to where the variant's file goes
+        fs::path dir = CaseDir(root, "variant");
+        WriteProgram(dir, variant, program);
+        fs::path file = OnlyFile(dir);
+        fs::path other = CaseDir(root, "variant-other");
+        WriteProgram(other, variant + 1, program);
+        fs::copy_file(OnlyFile(other), file, fs::copy_options::overwrite_existing);
+        ProgramCache reader(dir.string());
+        ok &= Check("file for another variant is a miss", reader.Find(kScript, variant) == nullptr);
+    }
+
+    {
+        // Key() is Hash(source) ^ variant * 0x9E3779B97F4A7C15. That constant is
+        // odd, so it has an inverse mod 2^64 (Newton's iteration), and some
+        // variant of kOtherScript lands on kScript's key for variant 0.
+        const uint64_t golden = 0x9E3779B97F4A7C15ull;
+        uint64_t inverse = golden;
+        for (int i = 0; i < 5; i++) inverse *= 2 - golden * inverse;
+        uint64_t otherVariant = (ProgramCache::Hash(kScript) ^ ProgramCache::Hash(kOtherScript)) * inverse;
+        bool collide = ProgramCache::Key(kScript, 0) == ProgramCache::Key(kOtherScript, otherVariant);
+        ok &= Check("crafted keys collide", collide);
+
+        Interpreter otherParser;
+        ProgramCache otherMemory;
+        otherParser.SetProgramCache(&otherMemory);
+        otherParser.Load(kOtherScript);
+        auto otherProgram = otherMemory.Find(kOtherScript, otherParser.FrontEndVariant());
+
+        fs::path dir = CaseDir(root, "collision");
+        ProgramCache cache(dir.string());
+        cache.Insert(kScript, 0, program);
+        cache.Insert(kOtherScript, otherVariant, otherProgram); // Replaces the entry and its file
+        auto found = cache.Find(kScript, 0);
+        ok &= Check("colliding source is not returned from memory", found == nullptr || found == program);
+        ok &= Check("colliding source keeps its own entry", cache.Find(kOtherScript, otherVariant) == otherProgram);
+
+        ProgramCache reader(dir.string());
+        found = reader.Find(kScript, 0);
+        ok &= Check("colliding source is not returned from its file", found == nullptr);
+        cache.Insert(kScript, 0, program);
+        ProgramCache rereader(dir.string());
+        ok &= Check("colliding file is not returned for the other source",
+                    rereader.Find(kOtherScript, otherVariant) == nullptr);
+    }
+
+    std::error_code error;
+    fs::remove_all(root, error);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,59 @@
+// Checks that Stop() interrupts a script sleeping on the real-time clock
+// instead of waiting the sleep out. Each case starts a script on its own
+// thread, waits until the script has marked pin 20 and gone to sleep, and
+// times Stop(); it must return within 100 ms.
+//
+// Exits 1 if any Stop() takes longer or the script gets past its sleep.
+#include "Interpreter.h"
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+static const double kMaxStopMillis = 100.0;
+
+static bool Check(const char* name, const char* script) {
+    Interpreter interpreter; // Real-time clock, script on its own thread
+    interpreter.Load(script);
+    interpreter.Start();
+
+    auto giveUp = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (interpreter.GetPinValue(20) != 1 && std::chrono::steady_clock::now() < giveUp) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    bool started = interpreter.GetPinValue(20) == 1;
+    std::this_thread::sleep_for(std::chrono::milliseconds(20)); // Well inside the sleep by now
+
+    auto start = std::chrono::steady_clock::now();
+    interpreter.Stop();
+    double millis = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    bool ok = started && millis <= kMaxStopMillis && interpreter.GetPinValue(21) == 0 && !interpreter.IsRunning();
+
+    printf("%s %s: Stop() took %.2f ms%s\n", ok ? "ok  " : "FAIL", name, millis,
+           started ? "" : ", script never started");
+    return ok;
+}
+
+int main() {
+    bool ok = true;
+    ok &= Check("delay(30000) in setup()",
+                "void setup() {\n"
+                "  digitalWrite(20, 1);\n"
+                "  delay(30000);\n"
+                "  digitalWrite(21, 1);\n"
+                "}\n"
+                "void loop() {}\n");
+    ok &= Check("delay(30000) in loop()",
+                "void loop() {\n"
+                "  digitalWrite(20, 1);\n"
+                "  delay(30000);\n"
+                "  digitalWrite(21, 1);\n"
+                "}\n");
+    ok &= Check("delayMicroseconds(20000000)",
+                "void setup() {\n"
+                "  digitalWrite(20, 1);\n"
+                "  delayMicroseconds(20000000);\n"
+                "  digitalWrite(21, 1);\n"
+                "}\n"
+                "void loop() {}\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,294 @@
+// Runs small scripts through the whole interpreter (parser, optimizer,
+// compiler and VM) and checks what they leave on the pins against values
+// worked out by hand: int and float arithmetic mixed the way C mixes it,
+// arrays and structs as values, piles pushed and popped through
+// references, `&` parameters, loops left by an early return, and `&&` and
+// `||` skipping their right-hand side. Recursion 10,000 calls deep must
+// finish; recursion without end must stop with a stack overflow error
+// naming the line of the call.
+//
+// Exits 1 on any mismatch.
+#include "Interpreter.h"
+#include "SimClock.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct Case {
+    const char* name;
+    const char* script;
+    std::vector<std::pair<int, int>> expected; // Pin, value
+    const char* error = "";                     // GetRuntimeError() once it has run
+};
+
+static const Case kCases[] = {
+    {
+        "int and float arithmetic",
+        "void setup() {\n"
+        "  int i = 7;\n"
+        "  float f = 2.5;\n"
+        "  digitalWrite(20, (int)((i + f) * 10));\n"  // 9.5
+        "  digitalWrite(21, (int)(i / 2 * f * 10));\n" // int division first: 3 * 2.5
+        "  int j = f * 3;\n"                           // 7.5 truncated on assignment
+        "  digitalWrite(22, j);\n"
+        "  float g = i / 2;\n"                         // 3, then converted
+        "  digitalWrite(23, (int)(g * 10));\n"
+        "  digitalWrite(24, -i / 2);\n"                // Truncates toward zero
+        "  digitalWrite(25, -i % 4);\n"
+        "  digitalWrite(26, (int)(i / 2.0 * 10));\n"
+        "  digitalWrite(27, (int)-f);\n"
+        "  int k = 0;\n"
+        "  if (f < i) k = 1;\n"
+        "  digitalWrite(28, k);\n"
+        "  digitalWrite(29, 1000000 * 3000);\n"       // Wraps like a 32-bit int
+        "}\n"
+        "void loop() { delay(1000); }\n",
+        { { 20, 95 }, { 21, 75 }, { 22, 7 }, { 23, 30 }, { 24, -3 }, { 25, -3 }, { 26, 35 }, { 27, -2 },
+          { 28, 1 }, { 29, -1294967296 } },
+    },
+    {
+        "arrays and structs",
+        "struct Point {\n"
+        "  int x;\n"
+        "  int y;\n"
+        "};\n"
+        "int squares[6];\n"
+        "Point origin;\n"
+        "int sum(int n) {\n"
+        "  int s = 0;\n"
+        "  for (int i = 0; i < n; i++) s = s + squares[i];\n"
+        "  return s;\n"
+        "}\n"
+        "void setup() {\n"
+        "  for (int i = 0; i < 6; i++) squares[i] = i * i;\n"
+        "  digitalWrite(20, sum(6));\n"
+        "  digitalWrite(21, squares[squares[2]]);\n"
+        "  Point p;\n"
+        "  p.x = 3;\n"
+        "  p.y = 4;\n"
+        "  Point q = p;\n"                // A copy: changing p leaves q alone
+        "  p.x = 30;\n"
+        "  digitalWrite(22, q.x * 100 + p.x);\n"
+        "  origin = p;\n"
+        "  origin.y = origin.y + 1;\n"
+        "  digitalWrite(23, origin.x * 100 + origin.y);\n"
+        "  digitalWrite(24, p.y);\n"
+        "  float half[3];\n"
+        "  half[1] = 7 / 2.0;\n"
+        "  digitalWrite(25, (int)(half[1] * 10));\n"
+        "}\n"
+        "void loop() { delay(1000); }\n",
+        { { 20, 55 }, { 21, 16 }, { 22, 330 }, { 23, 3005 }, { 24, 4 }, { 25, 35 } },
+    },
+    {
+        "piles through references",
+        "pile trail;\n"
+        "void fill(pile& p, int n) {\n"
+        "  for (int i = 1; i < n + 1; i++) push(p, i * 10);\n"
+        "}\n"
+        "int drain(pile& p, int n) {\n"
+        "  int total = 0;\n"
+        "  for (int i = 0; i < n; i++) total = total * 100 + pop(p);\n"
+        "  return total;\n"
+        "}\n"
+        "int peekTop(pile p) {\n"          // By value: pops a copy
+        "  return pop(p);\n"
+        "}\n"
+        "void setup() {\n"
+        "  fill(trail, 3);\n"
+        "  digitalWrite(20, peekTop(trail));\n"
+        "  pile saved = trail;\n"          // A copy: draining trail leaves saved alone
+        "  digitalWrite(21, drain(trail, 3));\n"
+        "  digitalWrite(22, pop(trail));\n" // Empty: 0
+        "  digitalWrite(23, drain(saved, 2));\n"
+        "  push(saved, 5);\n"
+        "  digitalWrite(24, pop(saved) + pop(saved));\n"
+        "}\n"
+        "void loop() { delay(1000); }\n",
+        { { 20, 30 }, { 21, 302010 }, { 22, 0 }, { 23, 3020 }, { 24, 15 } },
+    },
+    {
+        "& parameters",
+        "struct Point {\n"
+        "  int x;\n"
+        "  int y;\n"
+        "};\n"
+        "int cells[4];\n"
+        "void swap(int& a, int& b) {\n"
+        "  int t = a;\n"
+        "  a = b;\n"
+        "  b = t;\n"
+        "}\n"
+        "void bump(int& v) { v = v + 1; }\n"
+        "void bumpTwice(int& v) {\n"
+        "  bump(v);\n"
+        "  bump(v);\n"
+        "}\n"
+        "void copyBump(int v) { v = v + 1; }\n"
+        "void moveRight(Point& p) { p.x = p.x + 1; }\n"
+        "void setup() {\n"
+        "  int a = 1;\n"
+        "  int b = 2;\n"
+        "  swap(a, b);\n"
+        "  digitalWrite(20, a * 10 + b);\n"
+        "  bumpTwice(a);\n"
+        "  copyBump(a);\n"
+        "  digitalWrite(21, a);\n"
+        "  cells[2] = 40;\n"
+        "  bump(cells[2]);\n"
+        "  digitalWrite(22, cells[2]);\n"
+        "  Point p;\n"
+        "  p.x = 5;\n"
+        "  moveRight(p);\n"
+        "  bump(p.y);\n"
+        "  digitalWrite(23, p.x * 10 + p.y);\n"
+        "}\n"
+        "void loop() { delay(1000); }\n",
+        { { 20, 21 }, { 21, 4 }, { 22, 41 }, { 23, 61 } },
+    },
+    {
+        "loops left by an early return",
+        "int values[8];\n"
+        "int firstAbove(int limit) {\n"
+        "  for (int i = 0; i < 8; i++) {\n"
+        "    if (values[i] > limit) return i;\n"
+        "  }\n"
+        "  return -1;\n"
+        "}\n"
+        "int countUntil(int limit) {\n"
+        "  int n = 0;\n"
+        "  while (1) {\n"
+        "    n++;\n"
+        "    if (n > limit) return n;\n"
+        "  }\n"
+        "  return -1;\n"
+        "}\n"
+        "int nested(int target) {\n"
+        "  for (int i = 0; i < 5; i++) {\n"
+        "    int j = 0;\n"
+        "    do {\n"
+        "      if (i * 10 + j > target) return i * 10 + j;\n"
+        "      j++;\n"
+        "    } while (j < 5);\n"
+        "  }\n"
+        "  return 0;\n"
+        "}\n"
+        "void setup() {\n"
+        "  for (int i = 0; i < 8; i++) values[i] = i * 3;\n"
+        "  digitalWrite(20, firstAbove(10));\n"
+        "  digitalWrite(21, firstAbove(100));\n"
+        "  digitalWrite(22, countUntil(5));\n"
+        "  digitalWrite(23, nested(32));\n"
+        "  digitalWrite(24, firstAbove(10) + firstAbove(0));\n" // Each call starts its loop afresh
+        "}\n"
+        "void loop() { delay(1000); }\n",
+        { { 20, 4 }, { 21, -1 }, { 22, 6 }, { 23, 33 }, { 24, 5 } },
+    },
+    {
+        "short-circuit && and ||",
+        "int calls = 0;\n"
+        "int seen(int v) {\n"
+        "  calls = calls * 10 + 1;\n"
+        "  return v;\n"
+        "}\n"
+        "void setup() {\n"
+        "  int r = 0;\n"
+        "  if (seen(0) && seen(1)) r = 1;\n"   // Right side skipped
+        "  digitalWrite(20, calls * 10 + r);\n"
+        "  calls = 0;\n"
+        "  if (seen(1) || seen(0)) r = 2;\n"   // Right side skipped
+        "  digitalWrite(21, calls * 10 + r);\n"
+        "  calls = 0;\n"
+        "  if (seen(1) && seen(0)) r = 3;\n"   // Both sides, false
+        "  digitalWrite(22, calls * 10 + r);\n"
+        "  calls = 0;\n"
+        "  if (seen(0) || seen(2)) r = 4;\n"   // Both sides, true
+        "  digitalWrite(23, calls * 10 + r);\n"
+        "  calls = 0;\n"
+        "  bool b = seen(0) && seen(1) || seen(3);\n"
+        "  digitalWrite(24, calls * 10 + b);\n"
+        "}\n"
+        "void loop() { delay(1000); }\n",
+        { { 20, 10 }, { 21, 12 }, { 22, 112 }, { 23, 114 }, { 24, 111 } },
+    },
+    {
+        "recursion 10,000 calls deep",
+        "int depth(int n) {\n"
+        "  if (n < 1) return 0;\n"
+        "  return depth(n - 1) + 1;\n"
+        "}\n"
+        "void walk(int n, int& visited) {\n"
+        "  visited++;\n"
+        "  if (n > 0) walk(n - 1, visited);\n"
+        "}\n"
+        "void setup() {\n"
+        "  digitalWrite(20, depth(10000));\n"
+        "  int visited = 0;\n"
+        "  walk(9999, visited);\n"
+        "  digitalWrite(21, visited);\n"
+        "}\n"
+        "void loop() { delay(1000); }\n",
+        { { 20, 10000 }, { 21, 10000 } },
+    },
+    {
+        "runaway recursion",
+        "int runaway(int n) {\n"
+        "  return runaway(n + 1) + 1;\n"
+        "}\n"
+        "void setup() {\n"
+        "  digitalWrite(20, 1);\n"
+        "  digitalWrite(21, runaway(0));\n"
+        "  digitalWrite(22, 1);\n"
+        "}\n"
+        "void loop() { delay(1000); }\n",
+        { { 20, 1 }, { 21, 0 }, { 22, 0 } },
+        "stack overflow at line 2",
+    },
+};
+
+// Every pin after two simulated seconds in lockstep
+static std::vector<int> Run(const char* script, std::string& error) {
+    SimClock clock;
+    clock.SetMode(SimClock::SIMULATED);
+    Interpreter interpreter;
+    interpreter.SetClock(&clock);
+    interpreter.SetLockstep(true);
+    interpreter.Load(script);
+    interpreter.Start();
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    for (;;) {
+        int64_t wake = interpreter.RunLockstep(deadline);
+        if (wake == INT64_MAX || wake > 2000000 || std::chrono::steady_clock::now() >= deadline) break;
+        clock.AdvanceTo(wake);
+    }
+    std::vector<int> pins(PinBank::kPinCount);
+    interpreter.GetPinValues(0, PinBank::kPinCount, pins.data());
+    error = interpreter.GetRuntimeError();
+    interpreter.Stop();
+    return pins;
+}
+
+static bool Check(const Case& c) {
+    std::string error;
+    std::vector<int> pins = Run(c.script, error);
+    bool ok = error == c.error;
+    for (auto& expected : c.expected) {
+        if (pins[expected.first] != expected.second) {
+            printf("     pin %d: %d, expected %d\n", expected.first, pins[expected.first], expected.second);
+            ok = false;
+        }
+    }
+    if (!ok && error != c.error) printf("     runtime error \"%s\", expected \"%s\"\n", error.c_str(), c.error);
+    printf("%s %s\n", ok ? "ok  " : "FAIL", c.name);
+    return ok;
+}
+
+int main() {
+    bool ok = true;
+    for (const Case& c : kCases) ok &= Check(c);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,198 @@
+// Checks WallGrid's ray casts against distances worked out by hand: a ray
+// from a cell centre stops 0.5 away at that cell's wall, a diagonal one
+// 0.5·√2 away in its corner, and one along an open row at the far wall.
+// Each case is traced boundary by boundary (TraceRay) and also cast through
+// CastRay(), which answers axis rays from the reach table.
+//
+// Then CastRays(), whose SIMD kernels (AVX2 or SSE2, whichever the build
+// has) must give exactly CastRay()'s answers: on generated mazes, from
+// points all over them, on cell edges and corners too, in every direction
+// and in directions within kAxisEpsilon of an axis.
+//
+// Last, walls are opened and closed at random through MazeGenerator::
+// SetWall(), which updates the reach table a row or column at a time. After
+// every edit, each axis ray must get the same answer as from a table built
+// from scratch, and as from walking the boundaries.
+//
+// Exits 1 on any mismatch.
+#include "MazeGenerator.h"
+#include "WallGrid.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+// A w x h maze with no inner walls: only its border (less the entrance and exit)
+static void OpenMaze(MazeGenerator& maze, int w, int h) {
+    maze.Generate(w, h, 1);
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            if (x < w - 1) maze.SetWall(x, y, WallGrid::WALL_EAST, false);
+            if (y < h - 1) maze.SetWall(x, y, WallGrid::WALL_SOUTH, false);
+        }
+    }
+}
+
+static bool Check(const char* name, float got, float expected) {
+    bool ok = got == expected;
+    printf("%s %s: %.9g, expected %.9g\n", ok ? "ok  " : "FAIL", name, got, expected);
+    return ok;
+}
+
+static bool CheckExact(const char* name, const WallGrid& walls, Vec2 start, Vec2 dir, float expected) {
+    char label[128];
+    bool ok = true;
+    snprintf(label, sizeof(label), "%s, traced", name);
+    ok &= Check(label, walls.TraceRay(start, dir, 100.0f), expected);
+    snprintf(label, sizeof(label), "%s, cast", name);
+    ok &= Check(label, walls.CastRay(start, dir, 100.0f), expected);
+    return ok;
+}
+
+static bool ExactDistances() {
+    MazeGenerator maze;
+    OpenMaze(maze, 5, 5);
+    // Cell (2, 2) walled on the east and south; cell (0, 4) open to the east
+    maze.SetWall(2, 2, WallGrid::WALL_EAST, true);
+    maze.SetWall(2, 2, WallGrid::WALL_SOUTH, true);
+    const WallGrid& walls = maze.Walls();
+    const float diagonal = sqrtf(0.5f);
+
+    bool ok = true;
+    ok &= CheckExact("centre to east wall", walls, { 2.5f, 2.5f }, { 1.0f, 0.0f }, 0.5f);
+    ok &= CheckExact("centre to south wall", walls, { 2.5f, 2.5f }, { 0.0f, 1.0f }, 0.5f);
+    ok &= CheckExact("centre across two cells to west border", walls, { 2.5f, 2.5f }, { -1.0f, 0.0f }, 2.5f);
+    ok &= CheckExact("open row to east border", walls, { 0.5f, 4.5f }, { 1.0f, 0.0f }, 4.5f);
+    ok &= CheckExact("quarter cell out through the exit", walls, { 2.5f, 0.25f }, { 0.0f, -1.0f }, 0.25f);
+    // Both boundaries are equally far; the diagonal stops in the corner
+    ok &= CheckExact("diagonal into corner", walls, { 2.5f, 2.5f }, { diagonal, diagonal }, 0.5f * sqrtf(2.0f));
+    ok &= Check("range cuts the ray", walls.TraceRay({ 0.5f, 4.5f }, { 1.0f, 0.0f }, 2.0f), 2.0f);
+    return ok;
+}
+
+// Every 2 degrees, plus each axis and directions just inside, on and just
+// outside kAxisEpsilon of it. An odd count leaves a scalar tail after the
+// SIMD groups.
+static void SweepDirections(std::vector<float>& dirX, std::vector<float>& dirY) {
+    for (int degrees = 0; degrees < 360; degrees += 2) {
+        float angle = degrees * 3.14159265f / 180.0f;
+        dirX.push_back(cosf(angle));
+        dirY.push_back(sinf(angle));
+    }
+    const float eps = WallGrid::kAxisEpsilon;
+    const float offsets[] = { 0.0f, 0.5f * eps, -0.5f * eps, 0.99f * eps, eps, -eps, 1.5f * eps };
+    for (float off : offsets) {
+        float along = sqrtf(1.0f - off * off);
+        dirX.push_back(along); dirY.push_back(off);
+        dirX.push_back(-along); dirY.push_back(off);
+        dirX.push_back(off); dirY.push_back(along);
+        dirX.push_back(off); dirY.push_back(-along);
+    }
+    if (dirX.size() % 2 == 0) {
+        dirX.push_back(sqrtf(0.5f));
+        dirY.push_back(sqrtf(0.5f));
+    }
+}
+
+// CastRays() against CastRay() ray by ray, bit for bit
+static bool BatchMatchesScalar(int w, int h, unsigned seed) {
+    MazeGenerator maze;
+    maze.Generate(w, h, seed);
+    const WallGrid& walls = maze.Walls();
+    std::vector<float> dirX, dirY;
+    SweepDirections(dirX, dirY);
+    int count = (int)dirX.size();
+    std::vector<float> batch(count);
+
+    long long rays = 0, mismatches = 0;
+    const float ranges[] = { 100.0f, 2.0f };
+    // Quarter cells: centres, edges and corners, including the far border
+    for (int qy = 0; qy <= 4 * h; qy++) {
+        for (int qx = 0; qx <= 4 * w; qx++) {
+            Vec2 start = { qx * 0.25f, qy * 0.25f };
+            for (float range : ranges) {
+                walls.CastRays(start, dirX.data(), dirY.data(), count, range, batch.data());
+                for (int i = 0; i < count; i++) {
+                    float scalar = walls.CastRay(start, { dirX[i], dirY[i] }, range);
+                    if (memcmp(&scalar, &batch[i], sizeof(float)) != 0) {
+                        if (mismatches++ < 5) {
+                            printf("     (%g, %g) dir (%.9g, %.9g) range %g: batch %.9g, scalar %.9g\n", start.x,
+                                   start.y, dirX[i], dirY[i], range, batch[i], scalar);
+                        }
+                    }
+                    rays++;
+                }
+            }
+        }
+    }
+    printf("%s batched rays on a %dx%d maze, seed %u: %lld rays, %lld differ\n", mismatches ? "FAIL" : "ok  ", w, h,
+           seed, rays, mismatches);
+    return mismatches == 0;
+}
+
+// The four axis directions, and each a little off its axis
+static const Vec2 kAxisDirs[] = {
+    { 1.0f, 0.0f }, { -1.0f, 0.0f }, { 0.0f, 1.0f }, { 0.0f, -1.0f },
+    { 1.0f, 5e-6f }, { -1.0f, -5e-6f }, { -5e-6f, 1.0f }, { 5e-6f, -1.0f },
+};
+
+static bool EditsKeepTableCurrent(int w, int h, unsigned seed, int edits) {
+    MazeGenerator maze;
+    maze.Generate(w, h, seed);
+    std::mt19937 random(seed);
+    const uint8_t sides[] = { WallGrid::WALL_NORTH, WallGrid::WALL_SOUTH, WallGrid::WALL_EAST, WallGrid::WALL_WEST };
+
+    long long rays = 0, stale = 0, untraced = 0;
+    for (int edit = 0; edit < edits; edit++) {
+        int x = (int)(random() % w);
+        int y = (int)(random() % h);
+        uint8_t side = sides[random() % 4];
+        bool present = random() % 2;
+        maze.SetWall(x, y, side, present);
+
+        WallGrid rebuilt;
+        rebuilt.Build(maze);
+        const WallGrid& walls = maze.Walls();
+        for (int cy = 0; cy < h; cy++) {
+            for (int cx = 0; cx < w; cx++) {
+                const Vec2 starts[] = { { cx + 0.5f, cy + 0.5f }, { cx + 0.25f, cy + 0.75f } };
+                for (Vec2 start : starts) {
+                    for (Vec2 dir : kAxisDirs) {
+                        float table = walls.CastRay(start, dir, 100.0f);
+                        float fresh = rebuilt.CastRay(start, dir, 100.0f);
+                        float traced = walls.TraceRay(start, dir, 100.0f);
+                        bool exactAxis = dir.x == 0.0f || dir.y == 0.0f;
+                        // Slightly off an axis the table ignores the drift, a few ulps at most
+                        bool agrees = exactAxis ? table == traced : fabsf(table - traced) < 1e-4f;
+                        if (table != fresh || !agrees) {
+                            if (stale + untraced < 5) {
+                                printf("     edit %d: (%g, %g) dir (%g, %g): table %.9g, rebuilt %.9g, traced %.9g\n",
+                                       edit, start.x, start.y, dir.x, dir.y, table, fresh, traced);
+                            }
+                            if (table != fresh) stale++;
+                            else untraced++;
+                        }
+                        rays++;
+                    }
+                }
+            }
+        }
+    }
+    bool ok = stale == 0 && untraced == 0;
+    printf("%s %d wall edits on a %dx%d maze: %lld axis rays, %lld differ from a rebuilt table, "
+           "%lld from tracing\n", ok ? "ok  " : "FAIL", edits, w, h, rays, stale, untraced);
+    return ok;
+}
+
+int main() {
+    bool ok = true;
+    ok &= ExactDistances();
+    ok &= BatchMatchesScalar(12, 12, 1);
+    ok &= BatchMatchesScalar(20, 20, 7);
+    ok &= BatchMatchesScalar(9, 3, 42);
+    ok &= BatchMatchesScalar(1, 1, 5);
+    ok &= EditsKeepTableCurrent(15, 10, 3, 400);
+    ok &= EditsKeepTableCurrent(6, 6, 11, 200);
+    return ok ? 0 : 1;
+}
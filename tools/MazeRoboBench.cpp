@@ -0,0 +1,220 @@
+// mazerobo-bench: times the interpreter on its own, without a maze or a
+// window, and prints one line per measurement.
+//
+//   mazerobo-bench load [--lines N] [--repeat N] [--emit FILE]
+//   mazerobo-bench run --script FILE [--repeat N] [--max-sim-time SECONDS] [--echo CM]
+//
+// load: times Interpreter::Load() (tokenize, parse, optimize, compile) on a
+// generated script of about N lines (10,000 by default), made of one block
+// of typical robot code repeated with its names numbered. No program cache
+// is attached, so every load parses. --emit also writes the script out.
+//
+// run: loads FILE once, then times running it on a simulated clock until it
+// stops or reaches --max-sim-time (1 s by default). Sleeps cost nothing, so
+// the time is spent executing the script: examples/flood_fill.cpp, say.
+// With --echo every pulseIn() reads CM, so a solver such as maze_solver.cpp
+// keeps exploring:
+//
+//   mazerobo-bench run --script maze_solver.cpp --echo 30 --max-sim-time 10000
+//
+// turns right and recurses once per simulated second, 10,000 calls deep.
+//
+// Each mode reports the mean, median and fastest of --repeat runs.
+#include "Interpreter.h"
+#include "SimClock.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static void Usage() {
+    std::cerr << "usage: mazerobo-bench load [--lines N] [--repeat N] [--emit FILE]\n"
+                 "       mazerobo-bench run --script FILE [--repeat N] [--max-sim-time SECONDS] [--echo CM]\n";
+}
+
+// Wall time a single run may take before it is cut short
+static const int64_t kMaxRunMicros = 60000000;
+
+static void Report(const char* what, std::vector<double> times) {
+    std::sort(times.begin(), times.end());
+    double mean = 0.0;
+    for (double t : times) mean += t / times.size();
+    printf("%s, %zu runs: mean %.3f ms, median %.3f ms, min %.3f ms\n", what, times.size(), mean,
+           times[times.size() / 2], times.front());
+}
+
+// One copy of the generated script's block; '#' becomes the copy's number.
+// Scripts have no ==, != or ?: operators, so neither does the block.
+static const char* kBlock =
+    "// Block #\n"
+    "const int LIMIT# = 20;\n"
+    "int dist#[4];\n"
+    "float speed# = 1.5;\n"
+    "pile path#;\n"
+    "\n"
+    "int readDistance#(int trig, int echo) {\n"
+    "    digitalWrite(trig, 1);\n"
+    "    delayMicroseconds(10);\n"
+    "    digitalWrite(trig, 0);\n"
+    "    return pulseIn(echo, 1, 30000) * 0.034 / 2;\n"
+    "}\n"
+    "\n"
+    "int clearest#() {\n"
+    "    int best = 0;\n"
+    "    for (int i = 1; i < 4; i++) {\n"
+    "        if (dist#[i] > dist#[best]) {\n"
+    "            best = i;\n"
+    "        } else if (!(dist#[i] < dist#[best]) && !(i % 2)) {\n"
+    "            best = i;\n"
+    "        }\n"
+    "    }\n"
+    "    return best;\n"
+    "}\n"
+    "\n"
+    "bool step#(int depth) {\n"
+    "    for (int i = 0; i < 4; i++) dist#[i] = readDistance#(2 * i + 2, 2 * i + 3);\n"
+    "    int way = clearest#();\n"
+    "    if (dist#[way] < LIMIT# || depth > 100) return false;\n"
+    "    while (way > 0) {\n"
+    "        right();\n"
+    "        way = way - 1;\n"
+    "    }\n"
+    "    forward();\n"
+    "    delay((int)(600 / speed#));\n"
+    "    stop();\n"
+    "    push(path#, way);\n"
+    "    if (depth > 50 && millis() > 100000) return true;\n"
+    "    return step#(depth + 1);\n"
+    "}\n"
+    "\n";
+
+static std::string GenerateScript(int lines) {
+    std::string block = kBlock;
+    int blockLines = (int)std::count(block.begin(), block.end(), '\n');
+    std::string script;
+    for (int copy = 0; copy * blockLines < lines; copy++) {
+        std::string number = std::to_string(copy);
+        for (char c : block) {
+            if (c == '#') script += number;
+            else script += c;
+        }
+    }
+    script += "void setup() {\n    step0(0);\n}\n\nvoid loop() {\n    delay(1000);\n}\n";
+    return script;
+}
+
+static int BenchLoad(int lines, int repeat, const std::string& emitPath) {
+    std::string script = GenerateScript(lines);
+    if (!emitPath.empty()) {
+        std::ofstream out(emitPath);
+        out << script;
+        if (!out) {
+            std::cerr << "mazerobo-bench: cannot write " << emitPath << "\n";
+            return 2;
+        }
+    }
+
+    std::vector<double> times;
+    Interpreter interpreter;
+    for (int i = 0; i < repeat; i++) {
+        auto start = std::chrono::steady_clock::now();
+        interpreter.Load(script);
+        times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    char what[64];
+    snprintf(what, sizeof(what), "load: %d lines", (int)std::count(script.begin(), script.end(), '\n'));
+    Report(what, times);
+    return 0;
+}
+
+static int BenchRun(const std::string& scriptPath, int repeat, double maxSimTime, float echo) {
+    std::ifstream file(scriptPath);
+    if (!file) {
+        std::cerr << "mazerobo-bench: cannot read " << scriptPath << "\n";
+        return 2;
+    }
+    std::stringstream code;
+    code << file.rdbuf();
+
+    SimClock clock;
+    clock.SetMode(SimClock::SIMULATED);
+    Interpreter interpreter;
+    interpreter.SetClock(&clock);
+    interpreter.Load(code.str());
+    if (echo >= 0.0f) {
+        // Stamped with the current pin sequence: always taken after the last motor command
+        interpreter.SetSensorSource([&interpreter, echo](int, float& distance, uint32_t& pinSequence) {
+            distance = echo;
+            pinSequence = interpreter.GetPinValues(0, 0, nullptr);
+            return true;
+        });
+    }
+
+    int64_t simLimit = (int64_t)(maxSimTime * 1e6);
+    std::vector<double> times;
+    for (int i = 0; i < repeat; i++) {
+        auto start = std::chrono::steady_clock::now();
+        auto deadline = start + std::chrono::microseconds(kMaxRunMicros);
+        interpreter.Start();
+        // Jump the clock straight to each wake time, as fast-forward does without physics
+        for (;;) {
+            int64_t wake = clock.WaitForScriptIdle(deadline);
+            if (wake == INT64_MAX || wake >= simLimit || std::chrono::steady_clock::now() >= deadline) break;
+            if (wake > clock.NowMicros()) clock.AdvanceTo(wake);
+        }
+        interpreter.Stop();
+        times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::string error = interpreter.GetRuntimeError();
+    if (!error.empty()) printf("script stopped: %s\n", error.c_str());
+    Report(("run: " + scriptPath).c_str(), times);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        Usage();
+        return 2;
+    }
+    std::string mode = argv[1];
+    int lines = 10000;
+    int repeat = 30;
+    std::string emitPath;
+    std::string scriptPath;
+    double maxSimTime = 1.0;
+    float echo = -1.0f;
+
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!value) {
+            Usage();
+            return 2;
+        }
+        if (arg == "--lines") lines = atoi(value);
+        else if (arg == "--repeat") repeat = atoi(value);
+        else if (arg == "--emit") emitPath = value;
+        else if (arg == "--script") scriptPath = value;
+        else if (arg == "--max-sim-time") maxSimTime = atof(value);
+        else if (arg == "--echo") echo = (float)atof(value);
+        else {
+            Usage();
+            return 2;
+        }
+        i++;
+    }
+    if (lines <= 0 || repeat <= 0) {
+        Usage();
+        return 2;
+    }
+
+    if (mode == "load") return BenchLoad(lines, repeat, emitPath);
+    if (mode == "run" && !scriptPath.empty()) return BenchRun(scriptPath, repeat, maxSimTime, echo);
+    Usage();
+    return 2;
+}
@@ -0,0 +1,158 @@
+// mazerobo-run: runs one script against one generated maze without a window,
+// as fast as the CPU allows, and prints the result as a single JSON line.
+//
+//   mazerobo-run --script solver.cpp [--maze-seed N] [--size WxH]
+//                [--max-sim-time SECONDS] [--max-wall-time SECONDS]
+//                [--sensor KIND:PIN:ANGLE[:RANGE[:BEAMS]]]... [--cache-dir DIR]
+//
+// Each --sensor adds one to the default rig, e.g. "ir:12:45:0.6" for an IR
+// proximity sensor on pin 12 looking 45 degrees right with a 0.6-cell range.
+//
+// With --cache-dir the parsed script is kept in DIR, so a batch of runs of
+// the same script parses it once, in whichever run comes first.
+//
+// The run ends when the robot reaches the exit, the script stops, or either
+// time limit passes. The script runs in lockstep, so the same seed, size and
+// script always give the same result.
+#include "MazeGenerator.h"
+#include "ProgramCache.h"
+#include "Simulation.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Simulated time between checks of the stop conditions
+static const int64_t kChunkMicros = 100000;
+
+static void Usage() {
+    std::cerr << "usage: mazerobo-run --script FILE [--maze-seed N] [--size WxH]\n"
+                 "                    [--max-sim-time SECONDS] [--max-wall-time SECONDS]\n"
+                 "                    [--sensor ultrasonic|ir|lidar:PIN:ANGLE[:RANGE[:BEAMS]]]... [--cache-dir DIR]\n";
+}
+
+static bool ParseSensor(const char* text, Simulation::SensorMount& mount) {
+    char kind[16];
+    mount = { Simulation::SensorMount::ULTRASONIC, 0, 0.0f };
+    int fields = sscanf(text, "%15[a-z]:%d:%f:%f:%d", kind, &mount.pin, &mount.angle, &mount.range, &mount.beams);
+    if (fields < 3 || mount.range <= 0.0f || mount.beams <= 0) return false;
+    if (strcmp(kind, "ultrasonic") == 0) mount.kind = Simulation::SensorMount::ULTRASONIC;
+    else if (strcmp(kind, "ir") == 0) mount.kind = Simulation::SensorMount::IR;
+    else if (strcmp(kind, "lidar") == 0) mount.kind = Simulation::SensorMount::LIDAR;
+    else return false;
+    return true;
+}
+
+static std::string JsonString(const std::string& text) {
+    std::string out = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if ((unsigned char)c < 0x20) {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out += escaped;
+        } else {
+            out += c;
+        }
+    }
+    return out + "\"";
+}
+
+int main(int argc, char** argv) {
+    std::string scriptPath;
+    unsigned seed = 1;
+    int width = 20;
+    int height = 20;
+    double maxSimTime = 600.0;
+    double maxWallTime = 60.0;
+    std::vector<Simulation::SensorMount> extraSensors;
+    std::string cacheDir;
+    
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!value) {
+            Usage();
+            return 2;
+        }
+        if (arg == "--script") scriptPath = value;
+        else if (arg == "--maze-seed") seed = (unsigned)strtoul(value, nullptr, 10);
+        else if (arg == "--size") {
+            if (sscanf(value, "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0) {
+                Usage();
+                return 2;
+            }
+        }
+        else if (arg == "--max-sim-time") maxSimTime = atof(value);
+        else if (arg == "--max-wall-time") maxWallTime = atof(value);
+        else if (arg == "--sensor") {
+            Simulation::SensorMount mount;
+            if (!ParseSensor(value, mount)) {
+                Usage();
+                return 2;
+            }
+            extraSensors.push_back(mount);
+        }
+        else if (arg == "--cache-dir") cacheDir = value;
+        else {
+            Usage();
+            return 2;
+        }
+        i++;
+    }
+    if (scriptPath.empty()) {
+        Usage();
+        return 2;
+    }
+    std::ifstream file(scriptPath);
+    if (!file) {
+        std::cerr << "mazerobo-run: cannot read " << scriptPath << "\n";
+        return 2;
+    }
+    std::stringstream code;
+    code << file.rdbuf();
+    
+    MazeGenerator maze;
+    maze.Generate(width, height, seed);
+    ProgramCache programCache(cacheDir); // Memory only without --cache-dir
+    Simulation simulation;
+    simulation.sharedProgramCache = &programCache;
+    simulation.useLockstep = true;
+    simulation.useSimulatedTime = true;
+    simulation.sensors.insert(simulation.sensors.end(), extraSensors.begin(), extraSensors.end());
+    simulation.Init(maze, code.str());
+    
+    auto start = std::chrono::steady_clock::now();
+    auto wallLimit = start + std::chrono::microseconds((int64_t)(maxWallTime * 1e6));
+    int64_t simLimit = (int64_t)(maxSimTime * 1e6);
+    const char* reason;
+    for (;;) {
+        auto now = std::chrono::steady_clock::now();
+        if (simulation.stats.reachedGoal) { reason = "goal"; break; }
+        if (!simulation.IsScriptRunning()) { reason = "script_stopped"; break; }
+        if (simulation.SimTimeMicros() >= simLimit) { reason = "max_sim_time"; break; }
+        if (now >= wallLimit) { reason = "max_wall_time"; break; }
+        int64_t until = std::min(simLimit, simulation.SimTimeMicros() + kChunkMicros);
+        simulation.RunUntil(until, std::min(wallLimit, now + std::chrono::milliseconds(50)));
+    }
+    double wallTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    
+    const Simulation::Stats& stats = simulation.stats;
+    char numbers[512];
+    snprintf(numbers, sizeof(numbers),
+             "\"reached_goal\":%s,\"goal_time\":%.6f,\"sim_time\":%.6f,\"wall_time\":%.3f,"
+             "\"distance\":%.4f,\"collisions\":%d,\"seed\":%u,\"width\":%d,\"height\":%d",
+             stats.reachedGoal ? "true" : "false", stats.reachedGoal ? stats.goalMicros / 1e6 : -1.0,
+             simulation.SimTimeMicros() / 1e6, wallTime, stats.distance, stats.collisions, seed, width, height);
+    std::cout << "{" << numbers << ",\"stop_reason\":" << JsonString(reason)
+              << ",\"error\":" << JsonString(simulation.GetScriptError()) << "}" << std::endl;
+    return 0;
+}